@@ -0,0 +1,132 @@
+#include <drivers/ata.h>
+#include <asm/ports.h>
+
+/* Polled PIO on the primary bus; the drive interrupt is masked with nIEN */
+
+static ata_drive_t drives[ATA_DRIVES];
+
+static int32_t ata_wait(int32_t data)
+{
+    for(uint32_t timeout = ATA_TIMEOUT; timeout; --timeout)
+    {
+        uint8_t status = port_byte_in(ATA_PRIMARY_IO + ATA_REG_STATUS);
+
+        if(status & ATA_STATUS_BSY)
+            continue;
+
+        if(status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+            return -1;
+
+        if(!data || (status & ATA_STATUS_DRQ))
+            return 0;
+    }
+
+    return -1;
+}
+
+static void ata_select(uint32_t drive, uint32_t lba, uint32_t count)
+{
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_DRIVE, 0xE0 | (drive << 4) | ((lba >> 24) & 0x0F));
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_SECTOR_COUNT, (uint8_t) count);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_LOW, (uint8_t) lba);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_MID, (uint8_t) (lba >> 8));
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_HIGH, (uint8_t) (lba >> 16));
+}
+
+static void ata_identify(uint32_t drive)
+{
+    uint16_t identify[ATA_SECTOR_SIZE / 2];
+
+    drives[drive].present = 0;
+    drives[drive].sectors = 0;
+
+    ata_select(drive, 0, 0);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+
+    /* A floating bus reads back 0xFF, an absent drive 0 */
+    uint8_t status = port_byte_in(ATA_PRIMARY_IO + ATA_REG_STATUS);
+    if(status == 0 || status == 0xFF)
+        return;
+
+    /* ATAPI and SATA bridges report a signature in the LBA registers */
+    if(ata_wait(0) < 0 || port_byte_in(ATA_PRIMARY_IO + ATA_REG_LBA_MID) || port_byte_in(ATA_PRIMARY_IO + ATA_REG_LBA_HIGH))
+        return;
+
+    if(ata_wait(1) < 0)
+        return;
+
+    for(uint32_t i = 0; i < ATA_SECTOR_SIZE / 2; ++i)
+        identify[i] = port_word_in(ATA_PRIMARY_IO + ATA_REG_DATA);
+
+    drives[drive].sectors = identify[60] | ((uint32_t) identify[61] << 16);
+    drives[drive].present = drives[drive].sectors != 0;
+}
+
+void init_ata()
+{
+    port_byte_out(ATA_PRIMARY_CONTROL, ATA_CONTROL_NIEN);
+
+    for(uint32_t drive = 0; drive < ATA_DRIVES; ++drive)
+        ata_identify(drive);
+}
+
+ata_drive_t *ata_drive(uint32_t drive)
+{
+    if(drive >= ATA_DRIVES || !drives[drive].present)
+        return 0;
+
+    return &drives[drive];
+}
+
+static int32_t ata_transfer(uint32_t drive, uint32_t lba, uint32_t count, uint16_t *buffer, int32_t write)
+{
+    if(!ata_drive(drive) || lba + count > drives[drive].sectors)
+        return -1;
+
+    while(count)
+    {
+        uint32_t batch = count > ATA_MAX_TRANSFER ? ATA_MAX_TRANSFER : count;
+
+        if(ata_wait(0) < 0)
+            return -1;
+
+        ata_select(drive, lba, batch);
+        port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, write ? ATA_CMD_WRITE_PIO : ATA_CMD_READ_PIO);
+
+        for(uint32_t sector = 0; sector < batch; ++sector)
+        {
+            if(ata_wait(1) < 0)
+                return -1;
+
+            for(uint32_t i = 0; i < ATA_SECTOR_SIZE / 2; ++i, ++buffer)
+            {
+                if(write)
+                    port_word_out(ATA_PRIMARY_IO + ATA_REG_DATA, *buffer);
+                else
+                    *buffer = port_word_in(ATA_PRIMARY_IO + ATA_REG_DATA);
+            }
+        }
+
+        lba += batch;
+        count -= batch;
+    }
+
+    if(write)
+    {
+        port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_CACHE_FLUSH);
+        if(ata_wait(0) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+int32_t ata_read(uint32_t drive, uint32_t lba, uint32_t count, void *buffer)
+{
+    return ata_transfer(drive, lba, count, (uint16_t*) buffer, 0);
+}
+
+int32_t ata_write(uint32_t drive, uint32_t lba, uint32_t count, void *buffer)
+{
+    return ata_transfer(drive, lba, count, (uint16_t*) buffer, 1);
+}
\ No newline at end of file
@@ -2,16 +2,14 @@
 #include <drivers/display.h>
 
 #include <kernel/cpu/isr.h>
-#include <kernel/tty.h>
+#include <kernel/task.h>
 
-#include <string.h>
 #include <asm/ports.h>
 
-#define BACKSPACE 0x0E
-#define ENTER 0x1C
-#define SC_MAX 57
-
-static char key_buffer[256];
+static uint8_t scancodes[KEYBOARD_BUFFER_SIZE];
+static volatile uint32_t scancode_head = 0;
+static volatile uint32_t scancode_tail = 0;
+static wait_queue_t keyboard_waiters;
 
 const char *sc_name[] = 
 {   
@@ -36,33 +34,31 @@ static void keyboard_callback(registers_t *regs)
 {
     uint8 scancode = port_byte_in(0x60);
 
-    if (scancode > SC_MAX) 
-        return;
+    // Line editing happens in the terminal thread, which reads these back
+    // through keyboard_read()
+    if (scancode_head - scancode_tail < KEYBOARD_BUFFER_SIZE)
+        scancodes[scancode_head++ % KEYBOARD_BUFFER_SIZE] = scancode;
+    task_wake_up(&keyboard_waiters);
+}
+
+// Blocks until a key event arrives. Waiting here is what marks a task as
+// interactive: the scheduler boosts it every time a key wakes it up.
+uint8_t keyboard_read()
+{
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    while (scancode_head == scancode_tail)
+        task_sleep_on(&keyboard_waiters);
+
+    uint8_t scancode = scancodes[scancode_tail++ % KEYBOARD_BUFFER_SIZE];
 
-    if (scancode == BACKSPACE) 
-    {
-        if (strback(key_buffer))
-            print_backspace();    
-    } 
-    else if (scancode == ENTER) 
-    {
-        print_nl();
-        execute_command(key_buffer);
-        key_buffer[0] = '\0';
-    } 
-    else 
-    {
-        char letter = sc_ascii[(int32) scancode];
-        strappchr(key_buffer, letter);
-        char str[2] = {
-            letter, 
-            '\0'
-        };
-        print(str);
-    }
+    IRQ_RESTORE(flags);
+    return scancode;
 }
 
 void init_keyboard() 
 {
+    wait_queue_init(&keyboard_waiters, SCHED_INPUT_BOOST);
     register_interrupt_handler(IRQ1, keyboard_callback);
 }
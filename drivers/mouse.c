@@ -2,6 +2,7 @@
 #include <drivers/display.h>
 #include <drivers/ports.h>
 #include <cpu/isr.h>
+#include <kernel/task.h>
 #include <libc/function.h>
 #include <drivers/cursor.h>
 #include <gui/wm.h>
@@ -24,6 +25,8 @@ static uint8_t mouse_data[4];
 static int mouse_x = 40, mouse_y = 12;
 static uint8_t mouse_buttons = 0;
 static bool mouse_initialized = false;
+static volatile uint32_t mouse_events = 0;
+static wait_queue_t mouse_waiters;
 
 void mouse_wait(uint8_t type) {
     uint32_t timeout = 100000;
@@ -97,11 +100,33 @@ void mouse_handler(registers_t *regs) {
                 mouse_callback(mouse_cursor.x, mouse_cursor.y, mouse_buttons);
             }
             
+            ++mouse_events;
+            task_wake_up(&mouse_waiters);
+            
             mouse_cycle = 0;
             break;
     }
 }
 
+// block until a packet newer than `seen` arrives, return its sequence number
+uint32_t mouse_read_event(uint32_t seen, int *x, int *y, uint8_t *buttons) {
+    uint32_t flags;
+    IRQ_SAVE(flags);
+    
+    // sleeping here marks the caller as interactive for the scheduler
+    while (mouse_events == seen) {
+        task_sleep_on(&mouse_waiters);
+    }
+    
+    *x = mouse_x;
+    *y = mouse_y;
+    *buttons = mouse_buttons;
+    seen = mouse_events;
+    
+    IRQ_RESTORE(flags);
+    return seen;
+}
+
 void register_mouse_callback(mouse_callback_t callback) {
     mouse_callback = callback;
 }
@@ -127,6 +152,7 @@ void init_mouse() {
     mouse_write(0xF4);
     mouse_read();
     
+    wait_queue_init(&mouse_waiters, SCHED_INPUT_BOOST);
     register_interrupt_handler(IRQ12, mouse_handler);
     
     update_cursor(mouse_x, mouse_y);
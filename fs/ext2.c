@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <math.h>
 
+#include <kernel/memory/slab.h>
+
 #define EXT2_STATE_CLEAN 1
 #define EXT2_STATE_BROKEN 2
 
@@ -190,10 +192,15 @@ static void write_directory_entries(ext2_fs_t* fs, uint32_t ino, list_t* dir_ent
 static dentry_t* make_directory_entry(const char* name, uint32_t ino, uint32_t type);
 static void free_directory_entries(list_t* entries);
 
+static kmem_cache_t* dentry_cache;
+
 fs_t* init_ext2(uint8_t* data, uint32_t len) 
 {
     ext2_fs_t* e2fs = kmalloc(sizeof(ext2_fs_t));
 
+    if (!dentry_cache)
+        dentry_cache = kmem_cache_create("dentry_t", sizeof(dentry_t), 0, NULL);
+
     if (len < 1024 + sizeof(superblock_t)) 
     {
         printke("invalid volume: too small to be true");
@@ -244,7 +251,7 @@ int32_t ext2_unlink(ext2_fs_t* fs, uint32_t d_ino, uint32_t ino)
         if (ent->inode == ino) 
         {
             kfree(ent->name);
-            kfree(ent);
+            kmem_cache_free(dentry_cache, ent);
             list_del(iter);
             break;
         }
@@ -971,7 +978,7 @@ static list_t* directory_to_entries(ext2_fs_t* fs, uint32_t ino)
         if (!ent)
             break;
 
-        dentry_t* tn = kmalloc(sizeof(dentry_t));
+        dentry_t* tn = kmem_cache_alloc(dentry_cache);
         tn->name = strndup(ent->name, ent->name_len_low);
         tn->inode = ent->inode;
 
@@ -1033,7 +1040,7 @@ static void write_directory_entries(ext2_fs_t* fs, uint32_t ino, list_t* dir_ent
 
 static dentry_t* make_directory_entry(const char* name, uint32_t ino, uint32_t type) 
 {
-    dentry_t* tn = kmalloc(sizeof(dentry_t));
+    dentry_t* tn = kmem_cache_alloc(dentry_cache);
 
     tn->inode = ino;
     tn->name = strdup(name);
@@ -1048,7 +1055,7 @@ static void free_directory_entries(list_t* entries)
     {
         dentry_t* tn = list_first_entry(entries, dentry_t);
         kfree(tn->name);
-        kfree(tn);
+        kmem_cache_free(dentry_cache, tn);
         list_del(list_first(entries));
     }
 }
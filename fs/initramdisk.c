@@ -1,4 +1,6 @@
 #include <fs/initramdisk.h>
+#include <kernel/memory/slab.h>
+#include <panic.h>
 
 initrd_header_t *initrd_header;
 initrd_file_header_t *file_headers;
@@ -9,6 +11,11 @@ filesystem_node_t *root_nodes;
 
 int32_t number_of_root_nodes;
 
+static kmem_cache_t *node_cache;
+
+static filesystem_node_t *devices[INITRD_MAX_DEVICES];
+static uint32_t number_of_devices = 0;
+
 struct Dirent dirent;
 
 static uint32_t initramdisk_read(filesystem_node_t *node, uint32_t offset, uint32_t size, uint8_t *buffer)
@@ -27,6 +34,16 @@ static uint32_t initramdisk_read(filesystem_node_t *node, uint32_t offset, uint3
 
 static struct Dirent *initramdisk_readdir(filesystem_node_t *node, uint32_t index)
 {
+    if(node == initrd_dev)
+    {
+        if(index >= number_of_devices)
+            return 0;
+
+        strcpy(dirent.name, devices[index]->name);
+        dirent.ino = devices[index]->inode;
+        return &dirent;
+    }
+
     if(index - 1 > number_of_root_nodes)
         return 0;
 
@@ -49,6 +66,17 @@ static filesystem_node_t *initramdisk_finddir(filesystem_node_t *node, char *nam
     if(node == initrd_root && !strcmp(name, "dev"))
         return initrd_dev;
 
+    if(node == initrd_dev)
+    {
+        for(uint32_t i = 0; i < number_of_devices; ++i)
+        {
+            if(!strcmp(name, devices[i]->name))
+                return devices[i];
+        }
+
+        return 0;
+    }
+
     for(int32_t i = 0; i < number_of_root_nodes; ++i)
     {
         if(!strcmp(name, root_nodes[i].name))
@@ -58,14 +86,24 @@ static filesystem_node_t *initramdisk_finddir(filesystem_node_t *node, char *nam
     return 0;
 }
 
+void initramdisk_add_device(filesystem_node_t *node)
+{
+    if(number_of_devices == INITRD_MAX_DEVICES)
+        PANIC("Too many device nodes");
+
+    devices[number_of_devices++] = node;
+}
+
 filesystem_node_t *init_initial_ram_disk(uint32_t location)
 {
     // Init main and header fie pointers
     initrd_header = (initrd_header_t *) location;
     file_headers = (initrd_file_header_t *) (location + sizeof(initrd_header_t));
 
+    node_cache = kmem_cache_create("filesystem_node_t", sizeof(filesystem_node_t), 0, 0);
+
     // Init root directory
-    initrd_root = (filesystem_node_t *) malloc(sizeof(filesystem_node_t));
+    initrd_root = (filesystem_node_t *) kmem_cache_alloc(node_cache);
     strcpy(initrd_root->name, "initrd");
     initrd_root->mask = 0;
     initrd_root->uid = 0;
@@ -82,7 +120,7 @@ filesystem_node_t *init_initial_ram_disk(uint32_t location)
     initrd_root->ptr = 0;
     initrd_root->impl = 0;
 
-    initrd_dev = (filesystem_node_t *) malloc(sizeof(filesystem_node_t));
+    initrd_dev = (filesystem_node_t *) kmem_cache_alloc(node_cache);
     strcpy(initrd_dev->name, "dev");
     initrd_dev->mask = 0;
     initrd_dev->uid = 0;
@@ -1,5 +1,6 @@
 #include <gui/desktop.h>
 #include <gui/theme.h>
+#include <drivers/mouse.h>
 #include <libc/memory.h>
 #include <libc/stdio.h>
 #include <libc/string.h>
@@ -75,17 +76,17 @@ void desktop_run(desktop_environment_t *desktop) {
     
     printf("Starting desktop main loop...\n");
     
-    // Main desktop loop
+    uint32_t seen = 0;
+    int x, y;
+    uint8_t buttons;
+    
+    // Main desktop loop: sleep until the mouse moves instead of spinning,
+    // which also gives the loop the scheduler's input boost
     while (desktop->is_running) {
-        // In a real implementation, this would:
-        // 1. Process input events (mouse, keyboard)
-        // 2. Update window states
-        // 3. Render the desktop and all windows
+        seen = mouse_read_event(seen, &x, &y, &buttons);
+        desktop_handle_mouse(desktop, x, y, buttons);
         
-        // For now, we'll just render the desktop
         desktop_draw(desktop);
-        
-        // In a real implementation, we would have some kind of vsync or delay here
     }
 }
 
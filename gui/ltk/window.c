@@ -3,8 +3,11 @@
 #include <libc/string.h>
 #include <libc/memory.h>
 #include <libc/stdio.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/vmalloc.h>
 
 static uint32_t next_window_id = 1;
+static kmem_cache_t *window_cache = NULL;
 
 static void default_window_proc(window_t *window, int event_type, void *data) {
     return;
@@ -38,7 +41,11 @@ static void draw_window_frame(window_t *window) {
 }
 
 window_t *init_window(const char *title, uint32_t width, uint32_t height, uint32_t flags) {
-    window_t *window = (window_t*)kmalloc(sizeof(window_t));
+    if (!window_cache) {
+        window_cache = kmem_cache_create("window_t", sizeof(window_t), 0, NULL);
+    }
+    
+    window_t *window = (window_t*)kmem_cache_alloc(window_cache);
     if (!window) return NULL;
     
     window->id = next_window_id++;
@@ -59,10 +66,10 @@ window_t *init_window(const char *title, uint32_t width, uint32_t height, uint32
         window->title = NULL;
     }
     
-    window->framebuffer = (uint32_t*)kmalloc(width * height * sizeof(uint32_t));
+    window->framebuffer = (uint32_t*)vmalloc(width * height * sizeof(uint32_t));
     if (!window->framebuffer) {
         kfree(window->title);
-        kfree(window);
+        kmem_cache_free(window_cache, window);
         return NULL;
     }
     
@@ -89,9 +96,9 @@ void window_close(window_t *window) {
         kfree(window->title);
     }
     if (window->framebuffer) {
-        kfree(window->framebuffer);
+        vfree(window->framebuffer);
     }
-    kfree(window);
+    kmem_cache_free(window_cache, window);
 }
 
 void window_draw(window_t *window) {
@@ -128,10 +135,10 @@ void window_set_size(window_t *window, uint32_t width, uint32_t height) {
     
     // reallocate framebuffer
     if (window->framebuffer) {
-        kfree(window->framebuffer);
+        vfree(window->framebuffer);
     }
     
-    window->framebuffer = (uint32_t*)kmalloc(width * height * sizeof(uint32_t));
+    window->framebuffer = (uint32_t*)vmalloc(width * height * sizeof(uint32_t));
     if (!window->framebuffer) {
         // handle error - out of memory
         window->width = old_width;
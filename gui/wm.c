@@ -16,6 +16,7 @@ void wm_init() {
     wm_instance.active_window = NULL;
     wm_instance.drag_window = NULL;
     wm_instance.is_dragging = false;
+    wm_instance.frame_arena = arena_create("wm.frame", ARENA_CHUNK_SIZE);
     wm_initialized = true;
     
     printf("Window manager initialized\n");
@@ -104,6 +105,7 @@ static uint8_t wm_get_resize_edge(window_t *window, int x, int y) {
  * - Window dragging and resizing
  * - Focus management
  * - Mouse event handling
+ * - Per-frame scratch allocations from a bump arena (frame_arena)
  *
  * WINDOW MANAGEMENT:
  * - Maintains a list of all windows
@@ -297,17 +299,45 @@ void wm_handle_mouse(int x, int y, uint8_t buttons) {
     }
 }
 
+// check if a window is completely hidden behind one of the windows above it
+static bool wm_is_occluded(window_t *window, window_t **above, int count) {
+    for (int i = 0; i < count; i++) {
+        window_t *top = above[i];
+        if (top->x <= window->x && top->y <= window->y &&
+            top->x + top->width >= window->x + window->width &&
+            top->y + top->height >= window->y + window->height) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
 // render all windows
 void wm_render() {
     if (!wm_initialized) return;
     
-    // render windows in reverse order (back to front)
-    for (int i = 0; i < wm_instance.windows->size; i++) {
+    // the draw list only lives for this frame, so it comes from the frame arena
+    int count = wm_instance.windows->size;
+    window_t **draw_list = arena_alloc(wm_instance.frame_arena, count * sizeof(window_t*));
+    int drawn = 0;
+    
+    // collect windows top to bottom, skipping any that are fully covered
+    for (int i = count - 1; i >= 0; i--) {
         window_t *window = list_get(wm_instance.windows, i);
-        if (window && window->visible) {
-            window_draw(window);
-        }
+        if (!window || !window->visible) continue;
+        if (wm_is_occluded(window, draw_list, drawn)) continue;
+        
+        draw_list[drawn++] = window;
     }
+    
+    // render windows in reverse order (back to front)
+    for (int i = drawn - 1; i >= 0; i--) {
+        window_draw(draw_list[i]);
+    }
+    
+    // end of frame: everything allocated while rendering is dropped at once
+    arena_reset(wm_instance.frame_arena);
 }
 
 // get the window manager instance
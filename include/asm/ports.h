@@ -6,7 +6,7 @@
 #define port_byte_in(port) ({ \
     unsigned char _result; \
     __asm__ volatile("in %%dx, %%al" : "=a" (_result) : "d" (port)); \
-   return _result; \
+    _result; \
 })
 
 #define port_byte_out(port, data) ({ \
@@ -16,7 +16,7 @@
 #define port_word_in(port) ({ \
     unsigned short _result; \
     asm("in %%dx, %%ax" : "=a" (_result) : "d" (port)); \
-    return _result; \
+    _result; \
 })
 
 #define port_word_out(port, data) ({ \
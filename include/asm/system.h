@@ -7,23 +7,51 @@
 #define STI() __asm__ volatile("sti")
 #define HLT() __asm__ volatile("hlt")
 #define IRET() __asm__ volatile("iret")
+#define IRQ_SAVE(flags) __asm__ volatile("pushf\n pop %0\n cli" : "=r"(flags) :: "memory")
+#define IRQ_RESTORE(flags) __asm__ volatile("push %0\n popf" :: "r"(flags) : "memory", "cc")
+#define INVLPG(address) __asm__ volatile("invlpg (%0)" :: "r"(address) : "memory")
+#define CPUID(leaf, a, b, c, d) __asm__ volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(leaf))
+#define RDTSC(value) __asm__ volatile("rdtsc" : "=A"(value))
+#define CLTS() __asm__ volatile("clts")
 
+#define CPUID_EDX_PSE 0x00000008
+#define CPUID_EDX_PGE 0x00002000
+#define CPUID_EDX_FXSR 0x01000000
+#define CPUID_EDX_SSE 0x02000000
+
+#define CR0_MP 0x00000002
+#define CR0_EM 0x00000004
+#define CR0_TS 0x00000008
+#define CR0_NE 0x00000020
+
+#define CR4_PSE 0x00000010
+#define CR4_PGE 0x00000080
+#define CR4_OSFXSR 0x00000200
+#define CR4_OSXMMEXCPT 0x00000400
+
+// Carries on in ring 3 on the current stack. IF is set in the pushed
+// EFLAGS so the timer can preempt user code; the kernel side of the task
+// needs its esp0 in the TSS before this runs.
 #define switch_to_user_mode() \
     __asm__ volatile(" \
         cli\n \
-        mov $0x23, %ax\n \
-        mov %ax, %ds\n \
-        mov %ax, %es\n \
-        mov %ax, %fs\n \
-        mov %ax, %gs\n \
+        mov $0x23, %%ax\n \
+        mov %%ax, %%ds\n \
+        mov %%ax, %%es\n \
+        mov %%ax, %%fs\n \
+        mov %%ax, %%gs\n \
         \n \
-        mov %esp, %eax\n \
+        mov %%esp, %%eax\n \
         pushl $0x23\n \
+        pushl %%eax\n \
         pushf\n \
+        pop %%eax\n \
+        or $0x200, %%eax\n \
+        push %%eax\n \
         pushl $0x1B\n \
         push $1f\n \
         iret\n \
         1:\n \
-    ")
+    " ::: "eax", "memory")
 
 #endif
\ No newline at end of file
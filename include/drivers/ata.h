@@ -0,0 +1,51 @@
+#ifndef LUMAOS_ATA_H_
+#define LUMAOS_ATA_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define ATA_PRIMARY_IO 0x1F0
+#define ATA_PRIMARY_CONTROL 0x3F6
+
+#define ATA_REG_DATA 0
+#define ATA_REG_ERROR 1
+#define ATA_REG_SECTOR_COUNT 2
+#define ATA_REG_LBA_LOW 3
+#define ATA_REG_LBA_MID 4
+#define ATA_REG_LBA_HIGH 5
+#define ATA_REG_DRIVE 6
+#define ATA_REG_STATUS 7
+#define ATA_REG_COMMAND 7
+
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF  0x20
+#define ATA_STATUS_BSY 0x80
+
+#define ATA_CMD_READ_PIO 0x20
+#define ATA_CMD_WRITE_PIO 0x30
+#define ATA_CMD_CACHE_FLUSH 0xE7
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_CONTROL_NIEN 0x02
+
+#define ATA_MASTER 0
+#define ATA_SLAVE 1
+#define ATA_DRIVES 2
+#define ATA_SECTOR_SIZE 512
+#define ATA_MAX_TRANSFER 256
+#define ATA_TIMEOUT 100000
+
+typedef struct AtaDrive
+{
+    uint8_t present;
+    uint32_t sectors;
+} ata_drive_t;
+
+void init_ata();
+ata_drive_t *ata_drive(uint32_t drive);
+int32_t ata_read(uint32_t drive, uint32_t lba, uint32_t count, void *buffer);
+int32_t ata_write(uint32_t drive, uint32_t lba, uint32_t count, void *buffer);
+
+#endif
\ No newline at end of file
@@ -3,6 +3,17 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#define KEYBOARD_BUFFER_SIZE 64
+
+#define BACKSPACE 0x0E
+#define ENTER 0x1C
+#define SC_MAX 57
+
+extern const char sc_ascii[];
+
 void init_keyboard();
+uint8_t keyboard_read();
 
 #endif
\ No newline at end of file
@@ -51,6 +51,7 @@ int get_mouse_y();
 uint8_t get_mouse_buttons();
 bool is_mouse_initialized();
 void set_mouse_callback(mouse_callback_t callback);
+uint32_t mouse_read_event(uint32_t seen, int *x, int *y, uint8_t *buttons);
 
 /*
  * ============================================================
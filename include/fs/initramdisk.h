@@ -9,6 +9,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define INITRD_MAX_DEVICES 16
+
 typedef struct
 {
     uint32_t number_of_files;
@@ -23,5 +25,6 @@ typedef struct
 } initrd_file_header_t;
 
 filesystem_node_t *init_initial_ram_disk(uint32_t location);
+void initramdisk_add_device(filesystem_node_t *node);
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <gui/window.h>
 #include <libc/list.h>
+#include <kernel/memory/arena.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -35,6 +36,9 @@ typedef struct {
     bool is_dragging;           // is a window being dragged?
     bool is_resizing;           // is a window being resized?
     uint8_t resize_edge;        // which edge is being resized (WM_RESIZE_* flags)
+    
+    // per-frame scratch memory, reset at the end of every wm_render()
+    arena_t *frame_arena;
 } window_manager_t;
 
 // initialize window manager
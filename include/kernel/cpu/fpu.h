@@ -0,0 +1,19 @@
+#ifndef LUMAOS_FPU_H_
+#define LUMAOS_FPU_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <kernel/task.h>
+
+#define FPU_STATE_SIZE 512
+#define FPU_STATE_ALIGN 16
+#define MXCSR_DEFAULT 0x1F80
+
+void init_fpu();
+void fpu_switch(task_t *prev, task_t *next);
+void fpu_fork(task_t *parent, task_t *child);
+void fpu_release(task_t *task);
+
+#endif
\ No newline at end of file
@@ -10,6 +10,9 @@
 
 #define HZ 1193180
 
+extern uint32_t tick;
+extern uint32_t timer_frequency;
+
 void init_timer(uint32_t frequency);
 
 #endif
\ No newline at end of file
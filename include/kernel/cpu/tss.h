@@ -32,7 +32,7 @@ typedef struct TSSEntry
     uint32_t ds;
     uint32_t fs;
     uint32_t gs;
-    uint32_t ldt
+    uint32_t ldt;
     uint16_t trap;
     uint16_t iomap_base;
 } __attribute__((packed)) tss_entry_t;
@@ -0,0 +1,46 @@
+#ifndef LUMAOS_ARENA_H_
+#define LUMAOS_ARENA_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define ARENA_NAME_LENGTH 32
+#define ARENA_CHUNK_SIZE 0x4000
+#define ARENA_ALIGN 8
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *next;
+    uint32_t size;
+} arena_chunk_t;
+
+// Bump allocator for short-lived objects. Allocation moves a cursor
+// through the current chunk and there is no per-object free: the owner
+// calls arena_reset() once the batch (a frame, a request) is finished.
+// Chunks are kept across resets, so a steady-state frame never touches
+// the heap.
+typedef struct Arena
+{
+    char name[ARENA_NAME_LENGTH];
+    struct Arena *next;
+    arena_chunk_t *chunks;
+    arena_chunk_t *current;
+    uint32_t offset;
+    uint32_t chunk_size;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t high_water;
+    uint32_t allocations;
+    uint32_t resets;
+} arena_t;
+
+extern arena_t *arenas;
+
+arena_t *arena_create(const char *name, uint32_t chunk_size);
+void *arena_alloc(arena_t *arena, uint32_t size);
+void arena_reset(arena_t *arena);
+void arena_trim(arena_t *arena);
+void arena_destroy(arena_t *arena);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef LUMAOS_BUDDY_H_
+#define LUMAOS_BUDDY_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <kernel/memory/frame.h>
+
+#define BUDDY_MAX_ORDER 11
+#define BUDDY_NONE FRAME_NONE
+
+void buddy_init();
+void buddy_free_range(uint32_t first, uint32_t count);
+uint32_t buddy_alloc(uint32_t order);
+void buddy_free(uint32_t frame, uint32_t order);
+uint32_t buddy_free_frames();
+uint32_t buddy_order_for(uint32_t size);
+
+#endif
\ No newline at end of file
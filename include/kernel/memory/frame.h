@@ -0,0 +1,53 @@
+#ifndef LUMAOS_FRAME_H_
+#define LUMAOS_FRAME_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define FRAME_NONE 0xFFFFFFFF
+
+#define PF_BUDDY 0x01
+#define PF_DIRTY 0x02
+#define PF_LOCKED 0x04
+#define PF_SLAB 0x08
+#define PF_CACHE 0x10
+#define PF_LRU 0x20
+#define PF_ACTIVE 0x40
+
+struct Page;
+
+/* One descriptor per physical frame, indexed by frame number */
+typedef struct PageFrame
+{
+    struct Page *mapping;
+    uint32_t next;
+    uint32_t prev;
+    uint16_t refcount;
+    uint8_t order;
+    uint8_t flags;
+} page_frame_t;
+
+/* Intrusive list threaded through the descriptors' next/prev links */
+typedef struct FrameList
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t count;
+} frame_list_t;
+
+extern page_frame_t *page_frames;
+extern uint32_t number_of_frames;
+
+void frame_table_init(uint32_t frames);
+page_frame_t *frame_descriptor(uint32_t address);
+void frame_get(uint32_t frame);
+uint32_t frame_put(uint32_t frame);
+
+void frame_list_init(frame_list_t *list);
+void frame_list_push(frame_list_t *list, uint32_t frame);
+void frame_list_remove(frame_list_t *list, uint32_t frame);
+uint32_t frame_list_pop(frame_list_t *list);
+uint32_t frame_list_pop_tail(frame_list_t *list);
+
+#endif
\ No newline at end of file
@@ -3,16 +3,20 @@
 
 #pragma once
 
-#include <list.h>
 #include <stdint.h>
 
-#include <kernel/paging.h>
+#include <kernel/memory/paging.h>
 
 #define HEAP_START 0xC0000000
 #define HEAP_INITIAL_SIZE 0x100000
-#define HEAP_INDEX_SIZE 0x20000
+#define HEAP_MAX 0xCFFFF000
 #define HEAP_MAGIC 0x123890AB
 #define HEAP_MIN_SIZE 0x70000
+#define HEAP_SIZE_CLASSES 32
+#define HEAP_GROWTH_LIMIT 0x400000
+#define HEAP_RETAIN_SLACK 0x40000
+#define HEAP_TRIM_DELAY 8
+#define HEAP_SITES 64
 
 typedef struct Header
 {
@@ -27,24 +31,79 @@ typedef struct Footer
     header_t *header;
 } footer_t;
 
+/* Stored in the payload of a hole, right after its header */
+typedef struct HoleLinks
+{
+    header_t *next;
+    header_t *prev;
+} hole_links_t;
+
+#define HEAP_MIN_BLOCK (sizeof(header_t) + sizeof(hole_links_t) + sizeof(footer_t))
+
 typedef struct Heap
 {
-    ordered_list_t index;
+    header_t *free_lists[HEAP_SIZE_CLASSES];
+    uint32_t free_bitmap;
     uint32_t start_address;
     uint32_t end_address;
     uint32_t max_address;
     uint8_t supervisor;
     uint8_t readonly;
+    uint32_t retain_slack;
+    uint32_t trim_delay;
+    uint32_t trim_pending;
+    uint32_t expand_count;
+    uint32_t contract_count;
+    uint32_t bytes_in_use;
+    uint32_t blocks_in_use;
+    uint32_t alloc_calls;
+    uint32_t free_calls;
 } heap_t;
 
+typedef struct HeapStats
+{
+    uint32_t heap_size;
+    uint32_t bytes_in_use;
+    uint32_t blocks_in_use;
+    uint32_t free_bytes;
+    uint32_t hole_count;
+    uint32_t largest_hole;
+    uint32_t holes_by_class[HEAP_SIZE_CLASSES];
+    uint32_t expand_count;
+    uint32_t contract_count;
+    uint32_t alloc_calls;
+    uint32_t free_calls;
+} heap_stats_t;
+
+#ifdef HEAP_DEBUG
+/* Allocation totals per kmalloc caller, keyed by return address */
+typedef struct HeapSite
+{
+    uint32_t caller;
+    uint32_t allocations;
+    uint32_t bytes;
+} heap_site_t;
+
+extern heap_site_t heap_sites[HEAP_SITES];
+extern uint32_t heap_sites_dropped;
+#endif
+
+void init_heap(heap_t *heap, uint32_t start, uint32_t end_addr, uint32_t max, uint8_t supervisor, uint8_t readonly);
 heap_t *create_heap(uint32_t start, uint32_t end_addr, uint32_t max, uint8_t supervisor, uint8_t readonly);
 void *halloc(uint32_t size, uint8_t page_align, heap_t *heap);
 void hfree(void *p, heap_t *heap);
+void *hrealloc(void *p, uint32_t size, heap_t *heap);
+uint32_t hsize(void *p);
+void heap_stats(heap_t *heap, heap_stats_t *stats);
 uint32_t kmalloc_int(uint32_t size, int align, uint32_t *phys);
 uint32_t kmalloc_a(uint32_t size);
 uint32_t kmalloc_p(uint32_t size, uint32_t *phys);
 uint32_t kmalloc_ap(uint32_t size, uint32_t *phys);
 uint32_t kmalloc(uint32_t size);
 void kfree(void *p);
+void *krealloc(void *p, uint32_t size);
+uint32_t kmalloc_usable_size(void *p);
+void kheap_stats(heap_stats_t *stats);
+void init_heapinfo();
 
 #endif
\ No newline at end of file
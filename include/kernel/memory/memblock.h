@@ -0,0 +1,37 @@
+#ifndef LUMAOS_MEMBLOCK_H_
+#define LUMAOS_MEMBLOCK_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <system/multiboot.h>
+
+#define MEMBLOCK_MAX_REGIONS 32
+#define MEMBLOCK_LOW_LIMIT 0x100000
+#define MEMBLOCK_STACK_RESERVE 0x4000
+
+typedef struct MemblockRegion
+{
+    uint32_t base;
+    uint32_t end;
+} memblock_region_t;
+
+/* Sorted, non-overlapping ranges; adjacent ranges are merged on insertion */
+typedef struct MemblockType
+{
+    uint32_t count;
+    memblock_region_t regions[MEMBLOCK_MAX_REGIONS];
+} memblock_type_t;
+
+void memblock_init(multiboot_header_t *mboot, uint32_t kernel_end, uint32_t stack);
+void memblock_add(uint32_t base, uint32_t size);
+void memblock_reserve(uint32_t base, uint32_t size);
+uint32_t memblock_alloc(uint32_t size, uint32_t align);
+uint32_t memblock_alloc_range(uint32_t size, uint32_t align, uint32_t start, uint32_t end);
+void memblock_set_limit(uint32_t limit);
+uint32_t memblock_memory_end();
+uint32_t memblock_reserved_end();
+void memblock_free_all();
+
+#endif
\ No newline at end of file
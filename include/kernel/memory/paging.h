@@ -8,17 +8,45 @@
 #include <panic.h>
 #include <kernel/cpu/isr.h>
 
-#define INDEX_FROM_BIT(a) (a / (8 * 4))
-#define OFFSET_FROM_BIT(a) (a % (8 * 4))
+#define PAGE_FAULT_PRESENT 0x1
+#define PAGE_FAULT_WRITE   0x2
+#define PAGE_FAULT_USER    0x4
+
+#define PDE_PRESENT 0x001
+#define PDE_WRITE   0x002
+#define PDE_USER    0x004
+#define PDE_LARGE   0x080
+#define PDE_GLOBAL  0x100
+
+#define LARGE_PAGE_SIZE 0x400000
+#define IDENTITY_SLACK 0x4000
+#define TLB_FLUSH_THRESHOLD 32
+
+#define KMAP_BASE 0xFFC00000
+#define KMAP_SLOTS_PER_CPU 3
+#define KMAP_SOURCE 0
+#define KMAP_DESTINATION 1
+#define KMAP_POOL 2
+
+#define FRAME_ZERO 0x1
+#define ZERO_POOL_SIZE 64
+#define ZERO_POOL_BATCH 8
+#define ZERO_POOL_LOW (ZERO_POOL_SIZE / 2)
 
 typedef struct Page
 {
     uint32_t present : 1;
     uint32_t rw : 1;
     uint32_t user : 1;
+    uint32_t write_through : 1;
+    uint32_t cache_disable : 1;
     uint32_t accessed : 1;
     uint32_t dirty : 1;
-    uint32_t unused : 7;
+    uint32_t pat : 1;
+    uint32_t global : 1;
+    uint32_t cow : 1;
+    uint32_t swapped : 1;
+    uint32_t available : 1;
     uint32_t frame : 20;
 } page_t;
 
@@ -27,19 +55,31 @@ typedef struct PageTable
     page_t pages[1024];
 } page_table_t;
 
+struct VmArea;
+
 typedef struct PageDirectory
 {
     page_table_t *tables[1024];
     uint32_t tablesPhysical[1024];
     uint32_t physicalAddr;
+    struct VmArea *areas;
 } page_directory_t;
 
 void init_paging();
 void switch_page_directory(page_directory_t *newDir);
 void alloc_frame(page_t *page, int32_t is_kernel, int32_t is_writable);
+void alloc_frame_flags(page_t *page, int32_t is_kernel, int32_t is_writable, uint32_t flags);
+uint32_t zero_pool_refill(uint32_t budget);
+void zero_pool_start();
 void free_frame(page_t *page);
 page_t *get_page(uint32_t address, int32_t make, page_directory_t *dir);
+uint32_t get_physical_address(uint32_t address, page_directory_t *dir);
+void flush_tlb_range(page_directory_t *dir, uint32_t start, uint32_t size);
 void page_fault(registers_t *regs);
 page_directory_t *clone_directory(page_directory_t *src);
+void *kmap_slot(uint32_t slot, uint32_t frame);
+void kunmap_slot(uint32_t slot);
+void copy_page_physical(uint32_t source, uint32_t destination);
+void zero_page_physical(uint32_t address);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef LUMAOS_RECLAIM_H_
+#define LUMAOS_RECLAIM_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <kernel/memory/paging.h>
+
+#define SWAP_CLUSTER 8
+#define RECLAIM_WATERMARK 32
+
+/* Only write to devices that never allocate, for callers that may be inside the heap or slab */
+#define RECLAIM_NOALLOC 0x1
+
+void reclaim_init();
+void lru_add(uint32_t frame, page_t *page);
+void lru_remove(uint32_t frame);
+uint32_t reclaim_pages(uint32_t target, uint32_t mode);
+void reclaim_wake();
+void reclaim_start();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef LUMAOS_SLAB_H_
+#define LUMAOS_SLAB_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define SLAB_SIZE 0x1000
+#define SLAB_NAME_LENGTH 32
+#define CACHE_LINE_SIZE 64
+
+typedef void (*kmem_ctor_t)(void *);
+
+typedef struct Slab
+{
+    struct Slab *next;
+    struct Slab *prev;
+    struct KmemCache *cache;
+    void *free;
+    uint32_t in_use;
+    uint32_t frame;
+} slab_t;
+
+typedef struct KmemCache
+{
+    char name[SLAB_NAME_LENGTH];
+    uint32_t object_size;
+    uint32_t object_offset;
+    uint32_t objects_per_slab;
+    kmem_ctor_t ctor;
+    slab_t *partial;
+    slab_t *full;
+    slab_t *empty;
+    uint32_t slab_count;
+    uint32_t active_objects;
+} kmem_cache_t;
+
+kmem_cache_t *kmem_cache_create(const char *name, uint32_t size, uint32_t align, kmem_ctor_t ctor);
+void *kmem_cache_alloc(kmem_cache_t *cache);
+void kmem_cache_free(kmem_cache_t *cache, void *object);
+void kmem_cache_shrink(kmem_cache_t *cache);
+void kmem_cache_destroy(kmem_cache_t *cache);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef LUMAOS_SWAP_H_
+#define LUMAOS_SWAP_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define SWAP_MAX_DEVICES 4
+#define SWAP_DEVICE_SHIFT 18
+#define SWAP_MAX_SLOTS (0x1 << SWAP_DEVICE_SHIFT)
+#define SWAP_SLOT_MASK (SWAP_MAX_SLOTS - 1)
+#define SWAP_MAX_REFS 0xFFFF
+
+/* A swap entry lives in the frame field of a non-present PTE; slot 0 is never handed out so an entry is never 0 */
+#define SWAP_ENTRY(device, slot) (((device) << SWAP_DEVICE_SHIFT) | (slot))
+#define SWAP_DEVICE(entry) ((entry) >> SWAP_DEVICE_SHIFT)
+#define SWAP_SLOT(entry) ((entry) & SWAP_SLOT_MASK)
+
+/* The device allocates from the heap or slab to store a page */
+#define SWAP_ALLOCATES 0x1
+
+#define SWAP_ATA_DRIVE 1
+#define SWAP_SIGNATURE "SWAPSPACE2"
+#define SWAP_SIGNATURE_OFFSET 4086
+
+typedef struct SwapDevice
+{
+    const char *name;
+    uint32_t slots;
+    int32_t priority;
+    uint32_t flags;
+    int32_t (*read)(struct SwapDevice *device, uint32_t slot, void *page);
+    int32_t (*write)(struct SwapDevice *device, uint32_t slot, uint32_t count, void *pages);
+    void (*release)(struct SwapDevice *device, uint32_t slot);
+    void *data;
+    uint16_t *slot_refs;
+    uint32_t used;
+    uint32_t cursor;
+} swap_device_t;
+
+typedef struct SwapStats
+{
+    uint32_t scanned;
+    uint32_t activated;
+    uint32_t reclaimed;
+    uint32_t pages_out;
+    uint32_t pages_in;
+    uint32_t clusters;
+    uint32_t write_errors;
+    uint64_t reclaim_cycles;
+} swap_stats_t;
+
+extern swap_stats_t swap_stats;
+
+void init_swap();
+int32_t swap_on(swap_device_t *device);
+uint32_t swap_alloc(uint32_t count, uint32_t exclude);
+void swap_duplicate(uint32_t entry);
+void swap_free(uint32_t entry);
+int32_t swap_write(uint32_t entry, uint32_t count, void *pages);
+int32_t swap_read(uint32_t entry, uint32_t frame);
+uint32_t swap_free_slots();
+uint32_t swap_allocating_devices();
+
+#endif
\ No newline at end of file
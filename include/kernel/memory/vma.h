@@ -0,0 +1,28 @@
+#ifndef LUMAOS_VMA_H_
+#define LUMAOS_VMA_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <kernel/memory/paging.h>
+
+#define VMA_WRITE 0x1
+#define VMA_USER  0x2
+
+typedef struct VmArea
+{
+    uint32_t start;
+    uint32_t end;
+    uint32_t flags;
+    struct VmArea *next;
+} vm_area_t;
+
+void vma_insert(page_directory_t *dir, vm_area_t *area);
+vm_area_t *vma_add(page_directory_t *dir, uint32_t start, uint32_t end, uint32_t flags);
+void vma_remove(page_directory_t *dir, vm_area_t *area);
+vm_area_t *vma_find(page_directory_t *dir, uint32_t address);
+int32_t vma_user_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t flags);
+void vma_clone(page_directory_t *src, page_directory_t *dst);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef LUMAOS_VMALLOC_H_
+#define LUMAOS_VMALLOC_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define VMALLOC_START 0xD0000000
+#define VMALLOC_END   0xDF000000
+#define VMALLOC_GUARD 0x1000
+
+void *vmalloc(uint32_t size);
+void vfree(void *address);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef LUMAOS_VMM_H_
+#define LUMAOS_VMM_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#include <kernel/memory/paging.h>
+
+#define VMM_WRITE    0x01
+#define VMM_USER     0x02
+#define VMM_GLOBAL   0x04
+#define VMM_ALLOCATE 0x08
+#define VMM_ZERO     0x10
+
+void vmm_reserve_range(page_directory_t *dir, uint32_t start, uint32_t size);
+void vmm_map_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t physical, uint32_t flags);
+void vmm_unmap_range(page_directory_t *dir, uint32_t start, uint32_t size, int32_t release);
+void vmm_protect_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t flags);
+
+#endif
\ No newline at end of file
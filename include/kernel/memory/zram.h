@@ -0,0 +1,66 @@
+#ifndef LUMAOS_ZRAM_H_
+#define LUMAOS_ZRAM_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#define ZRAM_PRIORITY 100
+#define ZRAM_POOL_DIVISOR 4
+#define ZRAM_CLASS_SIZE 32
+#define ZRAM_CLASSES (0x1000 / ZRAM_CLASS_SIZE)
+#define ZRAM_MAX_ZSPAGE_FRAMES 4
+#define ZRAM_MAX_OBJECTS (ZRAM_MAX_ZSPAGE_FRAMES * 0x1000 / ZRAM_CLASS_SIZE)
+#define ZRAM_MAX_COMPRESSED (0x1000 * 3 / 4)
+
+#define ZRAM_EMPTY 0
+#define ZRAM_ZERO 1
+#define ZRAM_STORED 2
+
+/* A run of frames carved into equal objects of one size class; objects may straddle frames */
+typedef struct ZsPage
+{
+    struct ZsPage *next;
+    struct ZsPage *prev;
+    uint32_t frames[ZRAM_MAX_ZSPAGE_FRAMES];
+    uint32_t used[ZRAM_MAX_OBJECTS / 32];
+    uint16_t size_class;
+    uint16_t in_use;
+} zspage_t;
+
+typedef struct ZramClass
+{
+    uint32_t size;
+    uint32_t frames;
+    uint32_t objects;
+    zspage_t *partial;
+    zspage_t *full;
+} zram_class_t;
+
+typedef struct ZramSlot
+{
+    zspage_t *zspage;
+    uint16_t object;
+    uint16_t length;
+    uint8_t state;
+} zram_slot_t;
+
+typedef struct ZramStats
+{
+    uint32_t stored_pages;
+    uint32_t zero_pages;
+    uint32_t incompressible_pages;
+    uint32_t compressed_bytes;
+    uint32_t pool_frames;
+    uint32_t pool_limit;
+    uint32_t failed_writes;
+    uint32_t faults;
+    uint64_t fault_cycles;
+} zram_stats_t;
+
+extern zram_stats_t zram_stats;
+
+void init_zram();
+uint32_t zram_ratio();
+
+#endif
\ No newline at end of file
@@ -3,6 +3,11 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <system/sysinfo.h>
+
+#define SYSCALL_GET_SYSINFO 0
+
 void initialise_syscalls();
 
 #define DECL_SYSCALL0(fn) int syscall_##fn();
@@ -60,4 +65,6 @@ int syscall_##fn(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5) \
         return a; \
     }
 
+DECL_SYSCALL2(get_sysinfo, sysinfo_t*, uint32_t)
+
 #endif
\ No newline at end of file
@@ -5,23 +5,88 @@
 
 #include <stdint.h>
 
+#include <kernel/memory/paging.h>
+#include <kernel/cpu/isr.h>
+
 #define STACK_SIZE 4096
+#define SCHED_TIMESLICE_MS 20
+
+#define SCHED_PRIORITIES 32
+#define SCHED_DEFAULT_PRIORITY 15
+#define SCHED_IDLE_PRIORITY (SCHED_PRIORITIES - 1)
+#define SCHED_MAX_BOOST 4
+#define SCHED_INPUT_BOOST SCHED_MAX_BOOST
+
+#define NICE_MIN -15
+#define NICE_MAX 15
 
+#define TASK_RUNNABLE 0
+#define TASK_BLOCKED 1
+#define TASK_DEAD 2
+
+/* esp and cr3 are read by switch_to in kernel/asm/process.s and must stay
+   at offsets 4 and 8 */
 typedef struct Task
 {
     int32_t id;
     uint32_t esp;
-    uint32_t ebp;
-    uint32_t eip;
+    uint32_t cr3;
     uint32_t kernel_stack;
     page_directory_t *page_directory;
     struct Task *next;
+
+    int8_t nice;
+    uint8_t static_priority;
+    uint8_t priority;
+    uint8_t boost;
+    uint8_t state;
+
+    uint32_t timeslice;
+    uint32_t user_ticks;
+    uint32_t kernel_ticks;
+    uint32_t switches;
+    uint64_t cycles;
+    uint64_t switched_in;
+
+    uint8_t *fpu_state;
+
+    void (*entry)(void *arg);
+    void *arg;
 } task_t;
 
+/* Tasks blocked on an event. Tasks woken from it get `boost` levels of
+   priority on top of their nice level, decaying by one per full slice. */
+typedef struct WaitQueue
+{
+    task_t *head;
+    task_t *tail;
+    uint8_t boost;
+} wait_queue_t;
+
+extern volatile task_t *current_task;
+extern volatile uint32_t need_resched;
+
+extern void switch_to(task_t *prev, task_t *next);
+extern void fork_snapshot(task_t *child, void (*clone)(task_t *child));
+
 void init_taskmanager();
 void task_switch();
 int32_t task_fork();
 void move_stack(void *new_stack_start, uint32_t size);
+void setup();
 int32_t task_get_pid();
+void task_idle_start();
+task_t *kthread_create(void (*fn)(void *arg), void *arg);
+void kthread_exit();
+void task_yield();
+void task_preempt(registers_t *regs);
+void sched_tick(registers_t *regs);
+void sched_set_timeslice(uint32_t milliseconds);
+void task_init_context(task_t *task, uint32_t stack_top, void (*entry)());
+void task_switch_benchmark(uint32_t iterations, uint32_t *shared, uint32_t *reload);
+void task_set_nice(task_t *task, int32_t nice);
+void wait_queue_init(wait_queue_t *queue, uint8_t boost);
+void task_sleep_on(wait_queue_t *queue);
+void task_wake_up(wait_queue_t *queue);
 
 #endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <stdio.h>
 
 void init_tty();
+void init_terminal();
 void execute_command(char *command);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef LUMAOS_LZ4_H_
+#define LUMAOS_LZ4_H_
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MF_LIMIT 12
+#define LZ4_MAX_OFFSET 0xFFFF
+#define LZ4_HASH_BITS 12
+#define LZ4_HASH_SIZE (0x1 << LZ4_HASH_BITS)
+
+/* Raw LZ4 block format; the caller provides the LZ4_HASH_SIZE entry match table */
+int32_t lz4_compress(const uint8_t *source, uint32_t length, uint8_t *destination, uint32_t capacity, uint16_t *table);
+int32_t lz4_decompress(const uint8_t *source, uint32_t length, uint8_t *destination, uint32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -12,7 +12,8 @@ extern "C" {
 void memcpy(void *source, void *dest, size_t nbytes);
 void memset(void *dst, uint8_t value, size_t nbytes);
 
-void malloc(uint32_t size);
+void *malloc(uint32_t size);
+void *realloc(void *item, uint32_t size);
 void free(void *item);
 
 #ifdef __cplusplus
@@ -17,6 +17,12 @@
 #define MULTIBOOT_FLAG_APM     0x200
 #define MULTIBOOT_FLAG_VBE     0x400
 
+#define MULTIBOOT_MEMORY_AVAILABLE        1
+#define MULTIBOOT_MEMORY_RESERVED         2
+#define MULTIBOOT_MEMORY_ACPI_RECLAIMABLE 3
+#define MULTIBOOT_MEMORY_NVS              4
+#define MULTIBOOT_MEMORY_BADRAM           5
+
 typedef struct MultibootHeader
 {
     uint32_t flags;
@@ -45,4 +51,14 @@ typedef struct MultibootHeader
     uint32_t vbe_interface_len;
 } __attribute__((packed)) multiboot_header_t;
 
+typedef struct MultibootMemoryMap
+{
+    uint32_t size;
+    uint32_t base_low;
+    uint32_t base_high;
+    uint32_t length_low;
+    uint32_t length_high;
+    uint32_t type;
+} __attribute__((packed)) multiboot_memory_map_t;
+
 #endif
\ No newline at end of file
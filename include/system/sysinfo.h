@@ -21,10 +21,15 @@ typedef struct SysBuffer
 typedef struct SysInfo
 {
     uint32_t kernel_heap_usage;
+    uint32_t kernel_heap_size;
+    uint32_t kernel_heap_holes;
+    uint32_t kernel_heap_largest_hole;
     uint32_t ram_usage;
     uint32_t ram_total;
     float64_t uptime;
     char *kernel_log;
 } sysinfo_t;
 
+int32_t get_sysinfo(sysinfo_t *info, uint32_t what);
+
 #endif
@@ -38,7 +38,9 @@ irq_common_stub:
     mov fs, ax
     mov gs, ax
 
+    push esp
     call irq_handler
+    add esp, 4
 
     pop ebx   
     mov ds, bx
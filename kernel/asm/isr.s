@@ -63,7 +63,9 @@ isr_common_stub:
     mov fs, ax
     mov gs, ax
 
+    push esp
     call isr_handler
+    add esp, 4
 
     pop ebx
     mov ds, bx
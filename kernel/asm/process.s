@@ -1,36 +1,86 @@
-[GLOBAL read_eip]
-read_eip:
-    pop eax
-    jmp eax
+; Offsets into task_t, keep in sync with include/kernel/task.h
+TASK_ESP equ 4
+TASK_CR3 equ 8
 
-[GLOBAL copy_page_physical]
-copy_page_physical:
+; void switch_to(task_t *prev, task_t *next)
+; Saves the callee-saved registers on prev's stack and resumes next from
+; the frame it left on its own. Called with interrupts off.
+[GLOBAL switch_to]
+switch_to:
+    mov eax, [esp+4]
+    mov edx, [esp+8]
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax+TASK_ESP], esp
+
+    ; Task stacks sit at the same address in every directory, so nothing
+    ; may touch the stack between loading CR3 and loading ESP
+    mov ecx, [edx+TASK_CR3]
+    cmp ecx, [eax+TASK_CR3]
+    je .same_space
+    mov cr3, ecx
+.same_space:
+    mov esp, [edx+TASK_ESP]
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; void fork_snapshot(task_t *child, void (*clone)(task_t *child))
+; Leaves a switch_to frame on the stack, records it as the child's ESP and
+; calls clone while the frame is still there. The child's copy of the
+; stack then resumes by returning from here.
+[GLOBAL fork_snapshot]
+fork_snapshot:
+    push ebp
     push ebx
-    pushf
-                   
-    cli
-
-    mov ebx, [esp+12]
-    mov ecx, [esp+16]
-
-    mov edx, cr0
-    and edx, 0x7fffffff
-    mov cr0, edx
-
-    mov edx, 1024
-
-.loop:
-    mov eax, [ebx]
-    mov [ecx], eax
-    add ebx, 4
-    add ecx, 4
-    dec edx
-    jnz .loop
-  
-    mov edx, cr0
-    or  edx, 0x80000000
-    mov cr0, edx
-  
-    popf
+    push esi
+    push edi
+
+    mov eax, [esp+20]
+    mov [eax+TASK_ESP], esp
+    push eax
+    call [esp+28]
+    add esp, 4
+
+    pop edi
+    pop esi
     pop ebx
+    pop ebp
     ret
+
+[GLOBAL fast_copy_page]
+fast_copy_page:
+    push esi
+    push edi
+
+    mov edi, [esp+12]
+    mov esi, [esp+16]
+    mov ecx, 1024
+
+    cld
+    rep movsd
+
+    pop edi
+    pop esi
+    ret
+
+[GLOBAL fast_zero_page]
+fast_zero_page:
+    push edi
+
+    mov edi, [esp+8]
+    mov ecx, 1024
+    xor eax, eax
+
+    cld
+    rep stosd
+
+    pop edi
+    ret
\ No newline at end of file
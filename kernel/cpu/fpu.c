@@ -0,0 +1,159 @@
+#include <kernel/cpu/fpu.h>
+#include <kernel/cpu/isr.h>
+#include <kernel/memory/slab.h>
+#include <asm/system.h>
+#include <panic.h>
+
+/* The registers always hold fpu_owner's state. Everyone else runs with
+   CR0.TS set and only gets the FPU, via #NM, once they actually use it. */
+static task_t *fpu_owner = 0;
+static uint8_t ts_set = 0;
+static uint8_t has_fxsr = 0;
+
+static kmem_cache_t *fpu_cache;
+static uint8_t initial_state[FPU_STATE_SIZE] __attribute__((aligned(FPU_STATE_ALIGN)));
+
+static void set_ts()
+{
+    uint32_t cr0;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" :: "r"(cr0 | CR0_TS));
+    ts_set = 1;
+}
+
+static void clear_ts()
+{
+    CLTS();
+    ts_set = 0;
+}
+
+static void fpu_save(uint8_t *area)
+{
+    if (has_fxsr)
+        asm volatile("fxsave (%0)" :: "r"(area) : "memory");
+    else
+        asm volatile("fnsave (%0)\n frstor (%0)" :: "r"(area) : "memory");
+}
+
+static void fpu_restore(uint8_t *area)
+{
+    if (has_fxsr)
+        asm volatile("fxrstor (%0)" :: "r"(area) : "memory");
+    else
+        asm volatile("frstor (%0)" :: "r"(area) : "memory");
+}
+
+static uint8_t *fpu_area_create(uint8_t *source)
+{
+    uint32_t *area = (uint32_t*) kmem_cache_alloc(fpu_cache);
+
+    // Tasks cannot be killed yet, and the #NM handler has nothing to give
+    // back to the faulting instruction
+    if (!area)
+        PANIC("Out of memory for FPU state");
+
+    for (uint32_t i = 0; i < FPU_STATE_SIZE / 4; ++i)
+        area[i] = ((uint32_t*) source)[i];
+
+    return (uint8_t*) area;
+}
+
+// #NM: the current task touched the FPU while TS was set
+static void fpu_trap(registers_t *regs)
+{
+    clear_ts();
+
+    task_t *task = (task_t*) current_task;
+    if (!task || task == fpu_owner)
+        return;
+
+    if (fpu_owner)
+        fpu_save(fpu_owner->fpu_state);
+
+    if (!task->fpu_state)
+        task->fpu_state = fpu_area_create(initial_state);
+
+    fpu_restore(task->fpu_state);
+    fpu_owner = task;
+}
+
+void init_fpu()
+{
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(1, eax, ebx, ecx, edx);
+
+    uint32_t cr0;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    asm volatile("mov %0, %%cr0" :: "r"(cr0));
+
+    if (edx & CPUID_EDX_FXSR)
+    {
+        uint32_t cr4;
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= CR4_OSFXSR;
+        if (edx & CPUID_EDX_SSE)
+            cr4 |= CR4_OSXMMEXCPT;
+        asm volatile("mov %0, %%cr4" :: "r"(cr4));
+
+        has_fxsr = 1;
+    }
+
+    asm volatile("fninit");
+
+    if (edx & CPUID_EDX_SSE)
+    {
+        uint32_t mxcsr = MXCSR_DEFAULT;
+        asm volatile("ldmxcsr %0" :: "m"(mxcsr));
+    }
+
+    // Every task starts from this clean snapshot on its first #NM
+    fpu_save(initial_state);
+
+    fpu_cache = kmem_cache_create("fpu_state", FPU_STATE_SIZE, FPU_STATE_ALIGN, 0);
+    register_interrupt_handler(7, fpu_trap);
+
+    set_ts();
+}
+
+// Called from task_switch() with interrupts off. CR0 is only written when
+// TS actually has to change, so switching between tasks that never use
+// the FPU costs nothing.
+void fpu_switch(task_t *prev, task_t *next)
+{
+    if (next == fpu_owner)
+    {
+        if (ts_set)
+            clear_ts();
+    }
+    else if (!ts_set)
+    {
+        set_ts();
+    }
+}
+
+void fpu_fork(task_t *parent, task_t *child)
+{
+    child->fpu_state = 0;
+
+    if (!parent->fpu_state)
+        return;
+
+    // The parent is running, so if it owns the FPU its registers are live
+    if (parent == fpu_owner)
+        fpu_save(parent->fpu_state);
+
+    child->fpu_state = fpu_area_create(parent->fpu_state);
+}
+
+void fpu_release(task_t *task)
+{
+    if (task == fpu_owner)
+        fpu_owner = 0;
+
+    if (task->fpu_state)
+        kmem_cache_free(fpu_cache, task->fpu_state);
+
+    task->fpu_state = 0;
+}
\ No newline at end of file
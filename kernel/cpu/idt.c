@@ -71,7 +71,8 @@ void idt_init()
     idt_set_gate(45, (uint32_t) irq13, 0x08, 0x8E);
     idt_set_gate(46, (uint32_t) irq14, 0x08, 0x8E);
     idt_set_gate(47, (uint32_t) irq15, 0x08, 0x8E);
-    idt_set_gate(128, (uint32_t) isr128, 0x08, 0x8E);
+    // DPL 3, so user code can raise it with int 0x80
+    idt_set_gate(128, (uint32_t) isr128, 0x08, 0xEE);
 
     idt_flush((uint32_t) &idt_ptr);
 }
@@ -1,31 +1,39 @@
 #include <kernel/cpu/isr.h>
+#include <kernel/task.h>
+#include <asm/ports.h>
 
 #include <stdint.h>
 
-#define IRQ0 32
-#define IRQ1 33
-#define IRQ2 34
-#define IRQ3 35
-#define IRQ4 36
-#define IRQ5 37
-#define IRQ6 38
-#define IRQ7 39
-#define IRQ8 40
-#define IRQ9 41
-#define IRQ10 42
-#define IRQ11 43
-#define IRQ12 44
-#define IRQ13 45
-#define IRQ14 46
-#define IRQ15 47
-
-typedef struct Registers
+#define PIC1_COMMAND 0x20
+#define PIC2_COMMAND 0xA0
+#define PIC_EOI      0x20
+
+isr_t interrupt_handlers[256];
+
+void register_interrupt_handler(uint8_t n, isr_t handler)
 {
-    uint32_t ds;
-    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;
-    uint32_t int_no, err_code;
-    uint32_t eip, cs, eflags, useresp, ss;
-} registers_t;
-
-typedef void (*isr_t)(registers_t*);
-void register_interrupt_handler(uint8_t n, isr_t handler);
\ No newline at end of file
+    interrupt_handlers[n] = handler;
+}
+
+void isr_handler(registers_t *regs)
+{
+    if(interrupt_handlers[regs->int_no])
+        interrupt_handlers[regs->int_no](regs);
+
+    task_preempt(regs);
+}
+
+void irq_handler(registers_t *regs)
+{
+    // Acknowledge before running the handler: if it ends in a task switch
+    // this frame is only unwound once we are scheduled back in, and the
+    // PIC would hold back every line of equal or lower priority until then.
+    if(regs->int_no >= IRQ8)
+        port_byte_out(PIC2_COMMAND, PIC_EOI);
+    port_byte_out(PIC1_COMMAND, PIC_EOI);
+
+    if(interrupt_handlers[regs->int_no])
+        interrupt_handlers[regs->int_no](regs);
+
+    task_preempt(regs);
+}
\ No newline at end of file
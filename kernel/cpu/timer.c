@@ -4,13 +4,16 @@
 #include <system/misc.h>
 
 uint32_t tick = 0;
+uint32_t timer_frequency = 0;
 
 static void timer_callback(registers_t *regs) {
     ++tick;
+    sched_tick(regs);
 }
 
 void init_timer(uint32_t freq)
 {
+    timer_frequency = freq;
     register_interrupt_handler(IRQ0, timer_callback);
 
     uint32_t divisor = HZ / freq;
@@ -1,12 +1,19 @@
 #include <kernel/kernel.h>
 #include <kernel/task.h>
 #include <kernel/syscall.h>
+#include <kernel/tty.h>
 
 #include <kernel/memory/paging.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/memblock.h>
+#include <kernel/memory/swap.h>
+#include <kernel/memory/zram.h>
+#include <kernel/memory/reclaim.h>
 
 #include <kernel/cpu/gdt.h>
 #include <kernel/cpu/idt.h>
 #include <kernel/cpu/timer.h>
+#include <kernel/cpu/fpu.h>
 
 #include <driver/keyboard.h>
 #include <driver/mouse.h>
@@ -27,10 +34,9 @@
 #endif
 
 #define HANDLERS 256
-#define TIMER 50
+#define TIMER 100
 
 extern isr_t interrupt_handlers[];
-extern uint32_t placement_address;
 
 uint32_t initial_esp;
 
@@ -42,7 +48,7 @@ char *str =
 "| |___| |_| | | | | | | (_| | |__| |____) |\n"\
 "|______\\__,_|_| |_| |_|\\__,_|\\____/|_____/ \n";
 
-int main(multiboot_t *mboot_ptr, uint32_t initial_stack)
+int main(multiboot_header_t *mboot_ptr, uint32_t initial_stack)
 {
     initial_esp = initial_stack;
 
@@ -55,7 +61,7 @@ int main(multiboot_t *mboot_ptr, uint32_t initial_stack)
     cls();
 
     STI();
-    timer_init(TIMER);
+    init_timer(TIMER);
     printf("[Init] Timer...");
 
     //ASSERT(mboot_ptr->mods_count > 0);
@@ -63,22 +69,28 @@ int main(multiboot_t *mboot_ptr, uint32_t initial_stack)
     uint32_t initrd_location = *((uint32_t*) mboot_ptr->mods_addr);
     uint32_t initrd_end = *(uint32_t*)(mboot_ptr->mods_addr + 4);
 
-    placement_address = initrd_end;
+    memblock_init(mboot_ptr, initrd_end, initial_stack);
 
     init_paging();
     printf("[Init] Paging...");
-    init_tasking();
+    init_swap();
+    printf("[Init] Swap...");
+    init_zram();
+    printf("[Init] zram...");
+    init_fpu();
+    printf("[Init] FPU...");
+    init_taskmanager();
     printf("[Init] Tasking...");
+    zero_pool_start();
+    reclaim_start();
 
     filesystem_root = init_initial_ram_disk();
     printf("[Init] Ramdisk...");
+    init_heapinfo();
 
-    init_syscalls();
+    initialise_syscalls();
     printf("[Init] Syscalls...");
 
-    switch_to_user_mode();
-    printf("[Init] Switching to User Mode...");
-
     init_keyboard();
     printf("[Init] Keyboard...");
     
@@ -86,10 +98,17 @@ int main(multiboot_t *mboot_ptr, uint32_t initial_stack)
     init_mouse();
     printf("[Init] PS/2 Mouse...");
 
+    init_terminal();
+
+    // HLT is privileged, so the idle loop gets a kernel thread of its own
+    // rather than running on this task once it is in ring 3
+    task_idle_start();
+
+    switch_to_user_mode();
+    printf("[Init] Switching to User Mode...");
+
     printf("%s\n", str);
     printf("LumaOS - by OGDev Studios (Copyright 2025)");
 
-    init_terminal();
-
     return 0;
 }
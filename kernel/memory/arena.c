@@ -0,0 +1,148 @@
+#include <kernel/memory/arena.h>
+#include <kernel/memory/heap.h>
+
+#include <string.h>
+
+#define CHUNK_HEADER ((sizeof(arena_chunk_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+arena_t *arenas = 0;
+
+static arena_chunk_t *chunk_create(arena_t *arena, uint32_t size)
+{
+    arena_chunk_t *chunk = (arena_chunk_t*) kmalloc(size);
+    chunk->next = 0;
+    chunk->size = size;
+    arena->capacity += size - CHUNK_HEADER;
+    return chunk;
+}
+
+// kmalloc only guarantees 4-byte alignment, so ARENA_ALIGN is applied to
+// the address rather than to the offset within the chunk.
+static uint32_t chunk_align(arena_chunk_t *chunk, uint32_t offset)
+{
+    uint32_t address = (uint32_t) chunk + offset;
+    address = (address + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    return address - (uint32_t) chunk;
+}
+
+static void chunk_release(arena_t *arena, arena_chunk_t *chunk)
+{
+    arena->capacity -= chunk->size - CHUNK_HEADER;
+    kfree(chunk);
+}
+
+arena_t *arena_create(const char *name, uint32_t chunk_size)
+{
+    // Fields the code below does not set are cleared here; the libc
+    // memset and memcpy do nothing yet
+    arena_t *arena = (arena_t*) kmalloc(sizeof(arena_t));
+    arena->capacity = 0;
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->allocations = 0;
+    arena->resets = 0;
+
+    uint32_t length = 0;
+    for(; name[length] && length < ARENA_NAME_LENGTH - 1; ++length)
+        arena->name[length] = name[length];
+    for(; length < ARENA_NAME_LENGTH; ++length)
+        arena->name[length] = 0;
+
+    if(chunk_size < CHUNK_HEADER + ARENA_ALIGN)
+        chunk_size = ARENA_CHUNK_SIZE;
+
+    arena->chunk_size = chunk_size;
+    arena->chunks = chunk_create(arena, chunk_size);
+    arena->current = arena->chunks;
+    arena->offset = CHUNK_HEADER;
+
+    arena->next = arenas;
+    arenas = arena;
+    return arena;
+}
+
+void *arena_alloc(arena_t *arena, uint32_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    uint32_t offset = chunk_align(arena->current, arena->offset);
+
+    if(offset + size > arena->current->size)
+    {
+        // Reuse chunks kept from earlier frames before asking the heap;
+        // one that is too small for this request is skipped, not freed,
+        // since the next frame will probably want it again.
+        arena_chunk_t *chunk = arena->current->next;
+        while(chunk && chunk_align(chunk, CHUNK_HEADER) + size > chunk->size)
+        {
+            arena->current = chunk;
+            chunk = chunk->next;
+        }
+
+        if(!chunk)
+        {
+            uint32_t chunk_size = arena->chunk_size;
+            if(CHUNK_HEADER + size + ARENA_ALIGN - 1 > chunk_size)
+                chunk_size = CHUNK_HEADER + size + ARENA_ALIGN - 1;
+
+            chunk = chunk_create(arena, chunk_size);
+            chunk->next = arena->current->next;
+            arena->current->next = chunk;
+        }
+
+        arena->current = chunk;
+        offset = chunk_align(chunk, CHUNK_HEADER);
+    }
+
+    void *result = (void*) ((uint32_t) arena->current + offset);
+    arena->offset = offset + size;
+    arena->used += size;
+    ++arena->allocations;
+
+    if(arena->used > arena->high_water)
+        arena->high_water = arena->used;
+
+    return result;
+}
+
+void arena_reset(arena_t *arena)
+{
+    arena->current = arena->chunks;
+    arena->offset = CHUNK_HEADER;
+    arena->used = 0;
+    ++arena->resets;
+}
+
+// Gives back every chunk but the first. Only safe between frames, when
+// nothing allocated from the arena is still referenced.
+void arena_trim(arena_t *arena)
+{
+    arena_chunk_t *chunk = arena->chunks->next;
+    while(chunk)
+    {
+        arena_chunk_t *next = chunk->next;
+        chunk_release(arena, chunk);
+        chunk = next;
+    }
+
+    arena->chunks->next = 0;
+    arena_reset(arena);
+}
+
+void arena_destroy(arena_t *arena)
+{
+    arena_t **link = &arenas;
+    while(*link && *link != arena)
+        link = &(*link)->next;
+    if(*link)
+        *link = arena->next;
+
+    arena_chunk_t *chunk = arena->chunks;
+    while(chunk)
+    {
+        arena_chunk_t *next = chunk->next;
+        chunk_release(arena, chunk);
+        chunk = next;
+    }
+
+    kfree(arena);
+}
\ No newline at end of file
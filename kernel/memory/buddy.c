@@ -0,0 +1,98 @@
+#include <kernel/memory/buddy.h>
+
+static frame_list_t free_lists[BUDDY_MAX_ORDER];
+static uint32_t free_frames;
+
+static void push_block(uint32_t frame, uint32_t order)
+{
+    page_frames[frame].order = order;
+    page_frames[frame].flags |= PF_BUDDY;
+    frame_list_push(&free_lists[order], frame);
+}
+
+static void remove_block(uint32_t frame, uint32_t order)
+{
+    frame_list_remove(&free_lists[order], frame);
+    page_frames[frame].flags &= ~PF_BUDDY;
+}
+
+void buddy_init()
+{
+    free_frames = 0;
+
+    for(uint32_t i = 0; i < BUDDY_MAX_ORDER; ++i)
+        frame_list_init(&free_lists[i]);
+}
+
+void buddy_free_range(uint32_t first, uint32_t count)
+{
+    uint32_t end = first + count;
+    if(end > number_of_frames)
+        end = number_of_frames;
+
+    while(first < end)
+    {
+        uint32_t order = BUDDY_MAX_ORDER - 1;
+        while(order > 0 && ((first & ((0x1 << order) - 1)) || first + (0x1 << order) > end))
+            --order;
+
+        buddy_free(first, order);
+        first += 0x1 << order;
+    }
+}
+
+uint32_t buddy_alloc(uint32_t order)
+{
+    uint32_t current = order;
+    while(current < BUDDY_MAX_ORDER && free_lists[current].head == FRAME_NONE)
+        ++current;
+
+    if(current == BUDDY_MAX_ORDER)
+        return BUDDY_NONE;
+
+    uint32_t frame = free_lists[current].head;
+    remove_block(frame, current);
+
+    while(current > order)
+    {
+        --current;
+        push_block(frame + (0x1 << current), current);
+    }
+
+    page_frames[frame].order = order;
+    free_frames -= 0x1 << order;
+    return frame;
+}
+
+void buddy_free(uint32_t frame, uint32_t order)
+{
+    free_frames += 0x1 << order;
+
+    while(order < BUDDY_MAX_ORDER - 1)
+    {
+        uint32_t buddy = frame ^ (0x1 << order);
+
+        if(buddy >= number_of_frames || !(page_frames[buddy].flags & PF_BUDDY) || page_frames[buddy].order != order)
+            break;
+
+        remove_block(buddy, order);
+        frame &= ~(0x1 << order);
+        ++order;
+    }
+
+    push_block(frame, order);
+}
+
+uint32_t buddy_free_frames()
+{
+    return free_frames;
+}
+
+uint32_t buddy_order_for(uint32_t size)
+{
+    uint32_t order = 0;
+    while((0x1000 << order) < size)
+        ++order;
+
+    return order;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <kernel/memory/frame.h>
+#include <kernel/memory/memblock.h>
+
+#include <panic.h>
+
+page_frame_t *page_frames = 0;
+uint32_t number_of_frames = 0;
+
+void frame_table_init(uint32_t frames)
+{
+    number_of_frames = frames;
+    page_frames = (page_frame_t*) memblock_alloc(sizeof(page_frame_t) * frames, 0x4);
+
+    for(uint32_t i = 0; i < frames; ++i)
+    {
+        page_frames[i].mapping = 0;
+        page_frames[i].next = FRAME_NONE;
+        page_frames[i].prev = FRAME_NONE;
+        page_frames[i].refcount = 0;
+        page_frames[i].order = 0;
+        page_frames[i].flags = 0;
+    }
+}
+
+page_frame_t *frame_descriptor(uint32_t address)
+{
+    uint32_t frame = address / 0x1000;
+    return frame < number_of_frames ? &page_frames[frame] : 0;
+}
+
+void frame_get(uint32_t frame)
+{
+    ++page_frames[frame].refcount;
+}
+
+uint32_t frame_put(uint32_t frame)
+{
+    if(page_frames[frame].refcount == 0)
+        PANIC("Frame reference underflow");
+
+    return --page_frames[frame].refcount;
+}
+
+void frame_list_init(frame_list_t *list)
+{
+    list->head = FRAME_NONE;
+    list->tail = FRAME_NONE;
+    list->count = 0;
+}
+
+void frame_list_push(frame_list_t *list, uint32_t frame)
+{
+    page_frames[frame].prev = FRAME_NONE;
+    page_frames[frame].next = list->head;
+
+    if(list->head != FRAME_NONE)
+        page_frames[list->head].prev = frame;
+    else
+        list->tail = frame;
+
+    list->head = frame;
+    ++list->count;
+}
+
+void frame_list_remove(frame_list_t *list, uint32_t frame)
+{
+    page_frame_t *page = &page_frames[frame];
+
+    if(page->prev != FRAME_NONE)
+        page_frames[page->prev].next = page->next;
+    else
+        list->head = page->next;
+
+    if(page->next != FRAME_NONE)
+        page_frames[page->next].prev = page->prev;
+    else
+        list->tail = page->prev;
+
+    page->next = FRAME_NONE;
+    page->prev = FRAME_NONE;
+    --list->count;
+}
+
+uint32_t frame_list_pop(frame_list_t *list)
+{
+    uint32_t frame = list->head;
+    if(frame != FRAME_NONE)
+        frame_list_remove(list, frame);
+
+    return frame;
+}
+
+uint32_t frame_list_pop_tail(frame_list_t *list)
+{
+    uint32_t frame = list->tail;
+    if(frame != FRAME_NONE)
+        frame_list_remove(list, frame);
+
+    return frame;
+}
\ No newline at end of file
@@ -1,24 +1,142 @@
 #include <kernel/memory/heap.h>
+#include <kernel/memory/vmm.h>
 
-extern uint32_t end;
-uint32_t placement_address = (uint32_t) &end;
 extern page_directory_t *kernel_directory;
 heap_t *heap = 0;
 
-static int8_t header_less_than(void *a, void *b)
+#ifdef HEAP_DEBUG
+heap_site_t heap_sites[HEAP_SITES];
+uint32_t heap_sites_dropped = 0;
+
+static void record_site(uint32_t caller, uint32_t size)
 {
-    return (((header_t*) a)->size < ((header_t*) b)->size) ? 1 : 0;
+    uint32_t index = (caller >> 2) % HEAP_SITES;
+
+    for(uint32_t probe = 0; probe < HEAP_SITES; ++probe)
+    {
+        heap_site_t *site = &heap_sites[(index + probe) % HEAP_SITES];
+
+        if(site->caller == caller || site->caller == 0)
+        {
+            site->caller = caller;
+            ++site->allocations;
+            site->bytes += size;
+            return;
+        }
+    }
+
+    ++heap_sites_dropped;
 }
 
-heap_t *create_heap(uint32_t start, uint32_t end_addr, uint32_t max, uint8_t supervisor, uint8_t readonly)
+#define RECORD_SITE(size) record_site((uint32_t) __builtin_return_address(0), size)
+#else
+#define RECORD_SITE(size)
+#endif
+
+static uint32_t size_class(uint32_t size)
 {
-    heap_t *heap = (heap_t*) kmalloc(sizeof(heap_t));
+    return 31 - __builtin_clz(size);
+}
+
+static hole_links_t *hole_links(header_t *header)
+{
+    return (hole_links_t*) ((uint32_t) header + sizeof(header_t));
+}
+
+static void write_footer(header_t *header)
+{
+    footer_t *footer = (footer_t*) ((uint32_t) header + header->size - sizeof(footer_t));
+    footer->magic = HEAP_MAGIC;
+    footer->header = header;
+}
 
-    heap->index = ordered_list_place((void*) start, HEAP_INDEX_SIZE, &header_less_than);
+static void insert_hole(header_t *header, heap_t *heap)
+{
+    uint32_t index = size_class(header->size);
+    hole_links_t *links = hole_links(header);
+
+    header->magic = HEAP_MAGIC;
+    header->is_hole = 1;
+    write_footer(header);
+
+    links->prev = 0;
+    links->next = heap->free_lists[index];
+    if(links->next)
+        hole_links(links->next)->prev = header;
+
+    heap->free_lists[index] = header;
+    heap->free_bitmap |= 0x1 << index;
+}
+
+static void remove_hole(header_t *header, heap_t *heap)
+{
+    uint32_t index = size_class(header->size);
+    hole_links_t *links = hole_links(header);
+
+    if(links->prev)
+        hole_links(links->prev)->next = links->next;
+    else
+        heap->free_lists[index] = links->next;
 
-    start += sizeof(type_t) *HEAP_INDEX_SIZE;
+    if(links->next)
+        hole_links(links->next)->prev = links->prev;
 
-    if(start & 0xFFFF000 != 0)
+    if(!heap->free_lists[index])
+        heap->free_bitmap &= ~(0x1 << index);
+}
+
+static uint32_t align_offset(header_t *header)
+{
+    uint32_t location = (uint32_t) header + sizeof(header_t);
+    uint32_t offset = 0;
+
+    if(location & 0xFFF)
+    {
+        offset = 0x1000 - (location & 0xFFF);
+        if(offset < HEAP_MIN_BLOCK)
+            offset += 0x1000;
+    }
+
+    return offset;
+}
+
+static header_t *find_hole(uint32_t size, uint8_t page_align, heap_t *heap)
+{
+    uint32_t needed = page_align ? size + 0x1000 + HEAP_MIN_BLOCK : size;
+    uint32_t index = size_class(needed);
+
+    if(index + 1 < HEAP_SIZE_CLASSES)
+    {
+        uint32_t mask = heap->free_bitmap & ~((0x1 << (index + 1)) - 1);
+        if(mask)
+            return heap->free_lists[__builtin_ctz(mask)];
+    }
+
+    if(!(heap->free_bitmap & (0x1 << index)))
+        return 0;
+
+    header_t *header = heap->free_lists[index];
+    while(header)
+    {
+        uint32_t offset = page_align ? align_offset(header) : 0;
+
+        if(header->size >= offset + size)
+            return header;
+
+        header = hole_links(header)->next;
+    }
+
+    return 0;
+}
+
+void init_heap(heap_t *heap, uint32_t start, uint32_t end_addr, uint32_t max, uint8_t supervisor, uint8_t readonly)
+{
+    /* memset in libc is an empty stub, so the bins are cleared by hand */
+    for(uint32_t index = 0; index < HEAP_SIZE_CLASSES; ++index)
+        heap->free_lists[index] = 0;
+    heap->free_bitmap = 0;
+
+    if(start & 0xFFF)
     {
         start &= 0xFFFFF000;
         start += 0x1000;
@@ -29,38 +147,57 @@ heap_t *create_heap(uint32_t start, uint32_t end_addr, uint32_t max, uint8_t sup
     heap->max_address = max;
     heap->supervisor = supervisor;
     heap->readonly = readonly;
+    heap->retain_slack = HEAP_RETAIN_SLACK;
+    heap->trim_delay = HEAP_TRIM_DELAY;
+    heap->trim_pending = 0;
+    heap->expand_count = 0;
+    heap->contract_count = 0;
+    heap->bytes_in_use = 0;
+    heap->blocks_in_use = 0;
+    heap->alloc_calls = 0;
+    heap->free_calls = 0;
 
     header_t *hole = (header_t*) start;
     hole->size = end_addr - start;
-    hole->magic = HEAP_MAGIC;
-    hole->is_hole = 1;
-    ordered_list_insert((void*) hole, &heap->index);     
+    insert_hole(hole, heap);
+}
+
+heap_t *create_heap(uint32_t start, uint32_t end_addr, uint32_t max, uint8_t supervisor, uint8_t readonly)
+{
+    heap_t *heap = (heap_t*) kmalloc(sizeof(heap_t));
+    init_heap(heap, start, end_addr, max, supervisor, readonly);
     return heap;
 }
 
 static void expand(uint32_t new_size, heap_t *heap)
 {
-    if(new_size & 0xFFFFF000 != 0)
+    uint32_t old_size = heap->end_address - heap->start_address;
+    uint32_t limit = heap->max_address - heap->start_address;
+    uint32_t growth = old_size < HEAP_GROWTH_LIMIT ? old_size : HEAP_GROWTH_LIMIT;
+
+    if(new_size & 0xFFF)
     {
         new_size &= 0xFFFFF000;
         new_size += 0x1000;
     }
 
-    uint32_t old_size = heap->end_address - heap->start_address;
-    uint32_t i = old_size;
+    if(new_size > limit)
+        PANIC("Heap exhausted");
 
-    while(i < new_size)
-    {
-        alloc_frame(get_page(heap->start_address + i, 1, kernel_directory), (heap->supervisor) ? 1 : 0, (heap->readonly) ? 0 : 1);
-        i += 0x1000;
-    }
+    if(new_size < old_size + growth)
+        new_size = (old_size + growth < limit) ? old_size + growth : limit;
+
+    if(new_size > old_size)
+        vmm_reserve_range(kernel_directory, heap->start_address + old_size, new_size - old_size);
 
     heap->end_address = heap->start_address + new_size;
+    heap->trim_pending = 0;
+    ++heap->expand_count;
 }
 
 static uint32_t contract(uint32_t new_size, heap_t *heap)
 {
-    if(new_size & 0x1000)
+    if(new_size & 0xFFF)
     {
         new_size &= 0xFFFFF000;
         new_size += 0x1000;
@@ -70,159 +207,135 @@ static uint32_t contract(uint32_t new_size, heap_t *heap)
         new_size = HEAP_MIN_SIZE;
 
     uint32_t old_size = heap->end_address - heap->start_address;
-    uint32_t i = old_size - 0x1000;
+    if(new_size >= old_size)
+        return old_size;
 
-    while(new_size < i)
-    {
-        free_frame(get_page(heap->start_address + i, 0, kernel_directory));
-        i -= 0x1000;
-    }
+    vmm_unmap_range(kernel_directory, heap->start_address + new_size, old_size - new_size, 1);
 
     heap->end_address = heap->start_address + new_size;
+    ++heap->contract_count;
     return new_size;
 }
 
-static uint32_t find_smallest_space(uint32_t size, uint8_t page_align, heap_t *heap)
+static uint32_t block_size(uint32_t size)
 {
-    uint32_t iterator = 0;
-    while(iterator < heap->index.size)
-    {
-        header_t *header = (header_t*) ordered_list_lookup(iterator, &heap->index);
+    uint32_t new_size = (size + sizeof(header_t) + sizeof(footer_t) + 0x3) & ~0x3;
+    return new_size < HEAP_MIN_BLOCK ? HEAP_MIN_BLOCK : new_size;
+}
 
-        if(page_align < 0)
-        {
-            uint32_t location = (uint32_t) header;
-            int32_t offset = 0;
+static void grow(uint32_t extra, heap_t *heap)
+{
+    uint32_t old_end_address = heap->end_address;
+    uint32_t old_length = old_end_address - heap->start_address;
 
-            if((location + sizeof(header_t)) & 0xFFFFF000 != 0)
-                offset = 0x1000 - (location + sizeof(header_t)) % 0x1000;
+    expand(old_length + extra, heap);
 
-            int32_t hole_size = (int32_t) header->size - offset;
+    footer_t *last_footer = (footer_t*) (old_end_address - sizeof(footer_t));
+    header_t *header;
 
-            if(hole_size >= (int32_t) size)
-                break;
-        }
-        else if(header->size >= size)
-            break;
-
-        ++iterator;
+    if(last_footer->magic == HEAP_MAGIC && last_footer->header->is_hole)
+    {
+        header = last_footer->header;
+        remove_hole(header, heap);
+        header->size += heap->end_address - old_end_address;
+    }
+    else
+    {
+        header = (header_t*) old_end_address;
+        header->size = heap->end_address - old_end_address;
     }
 
-    if(iterator == heap->index.size)
-        return -1;
-
-    return iterator;
+    insert_hole(header, heap);
 }
 
 void *halloc(uint32_t size, uint8_t page_align, heap_t *heap)
 {
-    uint32_t new_size = size + sizeof(header_t) + sizeof(footer_t);
-    int32_t iterator = find_smallest_space(new_size, page_align, heap);
+    uint32_t new_size = block_size(size);
+    header_t *hole = find_hole(new_size, page_align, heap);
 
-    if(iterator == -1)
+    if(!hole)
     {
-        uint32_t old_length = heap->end_address - heap->start_address;
-        uint32_t old_end_address = heap->end_address;
+        grow(new_size + (page_align ? 0x1000 + HEAP_MIN_BLOCK : 0), heap);
+        return halloc(size, page_align, heap);
+    }
 
-        expand(old_length + new_size, heap);
+    remove_hole(hole, heap);
 
-        uint32_t new_length = heap->end_address - heap->start_address;
+    uint32_t hole_position = (uint32_t) hole;
+    uint32_t hole_size = hole->size;
 
-        iterator = 0;
-        uint32_t index = -1;
-        uint32_t value = 0x0;
+    if(page_align)
+    {
+        uint32_t offset = align_offset(hole);
 
-        while(iterator > heap->index.size)
+        if(offset)
         {
-            uint32_t temp = (uint32_t) ordered_list_lookup(iterator, &heap->index);
-            if(temp > value)
-            {
-                value = temp;
-                index = iterator;
-            }
-
-            ++iterator;
-        }
+            hole->size = offset;
+            insert_hole(hole, heap);
 
-        if(index == -1)
-        {
-            header_t *header = (header_t*) old_end_address;
-            header->magic = HEAP_MAGIC;
-            header->size = new_length - old_length;
-            header->is_hole = 1;
-            footer_t *footer = (footer_t*)(old_end_address + header->size - sizeof(footer_t));
-            footer->magic = HEAP_MAGIC;
-            footer->header = header;
-            ordered_list_insert((void*)header, &heap->index);
-        }
-        else
-        {
-            header_t *header = ordered_list_lookup(index, &heap->index);
-            header->size += new_length - old_length;
-            footer_t *footer = (footer_t*)((uint32_t)header + header->size - sizeof(footer_t) );
-            footer->header = header;
-            footer->magic = HEAP_MAGIC;
+            hole_position += offset;
+            hole_size -= offset;
         }
-
-        return alloc(size, page_align, heap);
     }
 
-    header_t *original_hole_header = (header_t*) ordered_list_lookup(iterator, &heap->index);
-    uint32_t original_hole_pos = (uint32_t) original_hole_header;
-    uint32_t original_hole_size = original_hole_header->size;
+    if(hole_size - new_size < HEAP_MIN_BLOCK)
+        new_size = hole_size;
 
-    if(original_hole_size - new_size < sizeof(header_t) + sizeof(footer_t))
-    {
-        size += original_hole_size - new_size;
-        new_size = original_hole_size;
-    }
+    header_t *block_header = (header_t*) hole_position;
+    block_header->magic = HEAP_MAGIC;
+    block_header->is_hole = 0;
+    block_header->size = new_size;
+    write_footer(block_header);
 
-    if(page_align && original_hole_pos & 0xFFFFF0000)
+    if(hole_size > new_size)
     {
-        uint32_t new_location = original_hole_pos + 0x1000 - (original_hole_pos & 0xFFF) - sizeof(header_t);
-        header_t *hole_header = (header_t*)original_hole_pos;
-        hole_header->size = 0x1000 - (original_hole_pos & 0xFFF) - sizeof(header_t);
-        hole_header->magic = HEAP_MAGIC;
-        hole_header->is_hole = 1;
-        footer_t *hole_footer = (footer_t*) ((uint32_t) new_location - sizeof(footer_t));
-        hole_footer->magic = HEAP_MAGIC;
-        hole_footer->header = hole_header;
-        original_hole_pos = new_location;
-        original_hole_size = original_hole_size - hole_header->size;
-    }
-    else
-    {
-        ordered_list_remove(iterator, &heap->index);
+        header_t *hole_header = (header_t*) (hole_position + new_size);
+        hole_header->size = hole_size - new_size;
+        insert_hole(hole_header, heap);
     }
 
-    header_t *block_header = (header_t*) original_hole_pos;
-    block_header->magic = HEAP_MAGIC;
-    block_header->is_hole = 0;
-    block_header->size = new_size;
+    heap->bytes_in_use += new_size;
+    ++heap->blocks_in_use;
+    ++heap->alloc_calls;
 
-    footer_t *block_footer = (footer_t*) (original_hole_pos + sizeof(header_t) + size);
-    block_footer->magic = HEAP_MAGIC;
-    block_footer->header = block_header;
+    return (void*) (hole_position + sizeof(header_t));
+}
 
-    if(original_hole_size - new_size > 0)
+static void release(header_t *header, heap_t *heap)
+{
+    if((uint32_t) header > heap->start_address)
     {
-        header_t *hole_header = (header_t*) (original_hole_pos + sizeof(header_t) + size + sizeof(footer_t));
-        hole_header->magic = HEAP_MAGIC;
-        hole_header->is_hole = 1;
-        hole_header->size = original_hole_size - new_size;
+        footer_t *left_footer = (footer_t*) ((uint32_t) header - sizeof(footer_t));
 
-        footer_t *hole_footer = (footer_t*)((uint32_t) hole_header + original_hole_size - new_size - sizeof(footer_t));
-
-        if((uint32_t) hole_footer < heap->end_address)
+        if(left_footer->magic == HEAP_MAGIC && left_footer->header->is_hole)
         {
-            hole_footer->magic = HEAP_MAGIC;
-            hole_footer->header = hole_header;
+            header_t *left = left_footer->header;
+            remove_hole(left, heap);
+            left->size += header->size;
+            header = left;
         }
+    }
 
-        ordered_list_insert((void*) hole_header, &heap->index);
+    header_t *right = (header_t*) ((uint32_t) header + header->size);
+
+    if((uint32_t) right < heap->end_address && right->magic == HEAP_MAGIC && right->is_hole)
+    {
+        remove_hole(right, heap);
+        header->size += right->size;
     }
 
-    return (void*)((uint32_t) block_header + sizeof(header_t));
+    uint32_t retained = heap->retain_slack > HEAP_MIN_BLOCK ? heap->retain_slack : HEAP_MIN_BLOCK;
+
+    if((uint32_t) header + header->size == heap->end_address && header->size > retained + 0x1000 &&
+        ++heap->trim_pending >= heap->trim_delay)
+    {
+        uint32_t offset = (uint32_t) header - heap->start_address;
+        uint32_t new_length = contract(offset + retained, heap);
+        header->size = new_length - offset;
+        heap->trim_pending = 0;
+    }
+
+    insert_hole(header, heap);
 }
 
 void hfree(void *p, heap_t *heap)
@@ -231,110 +344,188 @@ void hfree(void *p, heap_t *heap)
         return;
 
     header_t *header = (header_t*) ((uint32_t) p - sizeof(header_t));
-    footer_t *footer = (footer_t*) ((uint32_t) header + header->size - sizeof(footer_t));
-    header_t *test_header = (header_t*) ((uint32_t) header + sizeof(footer_t));
-    footer_t *test_footer = (footer_t*) ((uint32_t) header - sizeof(footer_t));
 
-    header->is_hole = 1;
-    char do_add = 1;
+    if(header->magic != HEAP_MAGIC || header->is_hole)
+        PANIC("Heap corruption");
 
-    if(test_footer->magic == HEAP_MAGIC && test_footer->header->is_hole == 1)
-    {
-        uint32_t cache_size = header->size;
-        header = test_footer->header;
-        footer->header = header;
-        header->size += cache_size;
-        do_add = 0;
-    }
+    heap->bytes_in_use -= header->size;
+    --heap->blocks_in_use;
+    ++heap->free_calls;
 
-    if(test_header->magic == HEAP_MAGIC && test_header->is_hole)
-    {
-        header->size += test_header->size;
-        test_footer = (footer_t*) ((uint32_t) test_header + test_header->size - sizeof(footer_t));
-        footer = test_footer;
+    release(header, heap);
+}
 
-        uint32_t iterator = 0;
-        while((iterator < heap->index.size) && (ordered_list_lookup(iterator, &heap->index) != (void*) test_header))
-            ++iterator;
+void *hrealloc(void *p, uint32_t size, heap_t *heap)
+{
+    if(p == 0)
+        return halloc(size, 0, heap);
 
-        ordered_list_remove(iterator, &heap->index);        
+    if(size == 0)
+    {
+        hfree(p, heap);
+        return 0;
     }
 
-    if ((uint32_t) footer + sizeof(footer_t) == heap->end_address)
+    header_t *header = (header_t*) ((uint32_t) p - sizeof(header_t));
+    uint32_t new_size = block_size(size);
+
+    if(header->magic != HEAP_MAGIC || header->is_hole)
+        PANIC("Heap corruption");
+
+    if(new_size > header->size)
     {
-        uint32_t old_length = heap->end_address-heap->start_address;
-        uint32_t new_length = contract((uint32_t) header - heap->start_address, heap);
+        header_t *right = (header_t*) ((uint32_t) header + header->size);
+        uint32_t available = header->size;
+
+        if((uint32_t) right < heap->end_address && right->magic == HEAP_MAGIC && right->is_hole)
+            available += right->size;
 
-        if (header->size - (old_length-new_length) > 0)
+        if(available < new_size && (uint32_t) header + available == heap->end_address)
         {
-            header->size -= old_length-new_length;
-            footer = (footer_t*) ((uint32_t) header + header->size - sizeof(footer_t));
-            footer->magic = HEAP_MAGIC;
-            footer->header = header;
+            grow(new_size - available, heap);
+            right = (header_t*) ((uint32_t) header + header->size);
         }
-        else
+
+        if((uint32_t) right >= heap->end_address || right->magic != HEAP_MAGIC || !right->is_hole ||
+            header->size + right->size < new_size)
         {
-            uint32_t iterator = 0;
-            while ((iterator < heap->index.size) && (lookup_ordered_array(iterator, &heap->index) != (void*) test_header))
-                iterator++;
+            uint32_t *moved = halloc(size, 0, heap);
+            uint32_t *from = p;
+            uint32_t words = (header->size - sizeof(header_t) - sizeof(footer_t)) / 4;
+
+            while(words--)
+                moved[words] = from[words];
 
-            if (iterator < heap->index.size)
-                ordered_list_remove(iterator, &heap->index);
+            hfree(p, heap);
+            return moved;
         }
+
+        remove_hole(right, heap);
+        header->size += right->size;
+        heap->bytes_in_use += right->size;
+        write_footer(header);
     }
 
-    if (do_add == 1)
-        ordered_list_insert((void*) header, &heap->index);
+    if(header->size - new_size >= HEAP_MIN_BLOCK)
+    {
+        header_t *tail = (header_t*) ((uint32_t) header + new_size);
+        tail->magic = HEAP_MAGIC;
+        tail->is_hole = 0;
+        tail->size = header->size - new_size;
+        write_footer(tail);
+
+        header->size = new_size;
+        write_footer(header);
+
+        heap->bytes_in_use -= tail->size;
+        release(tail, heap);
+    }
+
+    return p;
 }
 
-uint32_t kmalloc_int(uint32_t size, int align, uint32_t *phys)
+uint32_t hsize(void *p)
 {
-    if(heap == 0)
+    header_t *header = (header_t*) ((uint32_t) p - sizeof(header_t));
+    return header->size - sizeof(header_t) - sizeof(footer_t);
+}
+
+void heap_stats(heap_t *heap, heap_stats_t *stats)
+{
+    // memset is a stub in libc; the loop below only adds to these
+    for(uint32_t index = 0; index < HEAP_SIZE_CLASSES; ++index)
+        stats->holes_by_class[index] = 0;
+    stats->free_bytes = 0;
+    stats->hole_count = 0;
+    stats->largest_hole = 0;
+
+    // An allocation from an interrupt handler would change the lists
+    // under the walk
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    stats->heap_size = heap->end_address - heap->start_address;
+    stats->bytes_in_use = heap->bytes_in_use;
+    stats->blocks_in_use = heap->blocks_in_use;
+    stats->expand_count = heap->expand_count;
+    stats->contract_count = heap->contract_count;
+    stats->alloc_calls = heap->alloc_calls;
+    stats->free_calls = heap->free_calls;
+
+    for(uint32_t index = 0; index < HEAP_SIZE_CLASSES; ++index)
     {
-        if(align == 1 && (placement_address & 0xFFFF000))
+        for(header_t *hole = heap->free_lists[index]; hole; hole = hole_links(hole)->next)
         {
-            placement_address &= 0xFFFFF000;
-            placement_address += 0x1000;
-        }
+            ++stats->holes_by_class[index];
+            ++stats->hole_count;
+            stats->free_bytes += hole->size;
 
-        if(phys)
-            *phys = placement_address;
-
-        uint32_t temp = placement_address;
-        placement_address += size;
-        return temp;
+            if(hole->size > stats->largest_hole)
+                stats->largest_hole = hole->size;
+        }
     }
 
+    IRQ_RESTORE(flags);
+}
+
+static uint32_t kalloc(uint32_t size, int align, uint32_t *phys)
+{
     void *addr = halloc(size, (uint8_t) align, heap);
     if(phys != 0)
     {
-        page_t *page = get_page((uint32_t) addr, 0, kernel_directory);
-        *phys = page->frame * 0x1000 + ((uint32_t) addr & 0xFFF);
+        *(volatile uint8_t*) addr;
+        *phys = get_physical_address((uint32_t) addr, kernel_directory);
     }
     return (uint32_t) addr;    
 }
 
+uint32_t kmalloc_int(uint32_t size, int align, uint32_t *phys)
+{
+    RECORD_SITE(size);
+    return kalloc(size, align, phys);
+}
+
 uint32_t kmalloc_a(uint32_t size)
 {
-    return kmalloc_int(size, 1, 0);
+    RECORD_SITE(size);
+    return kalloc(size, 1, 0);
 }
 
 uint32_t kmalloc_p(uint32_t size, uint32_t *phys)
 {
-    return kmalloc_int(size, 0, phys);
+    RECORD_SITE(size);
+    return kalloc(size, 0, phys);
 }
 
 uint32_t kmalloc_ap(uint32_t size, uint32_t *phys)
 {
-    return kmalloc_int(size, 1, phys);
+    RECORD_SITE(size);
+    return kalloc(size, 1, phys);
 }
 
 uint32_t kmalloc(uint32_t size)
 {
-    return kmalloc_int(size, 0, 0);
+    RECORD_SITE(size);
+    return kalloc(size, 0, 0);
 }
 
 void kfree(void *p)
 {
     hfree(p, heap);
+}
+
+void *krealloc(void *p, uint32_t size)
+{
+    RECORD_SITE(size);
+    return hrealloc(p, size, heap);
+}
+
+uint32_t kmalloc_usable_size(void *p)
+{
+    return p ? hsize(p) : 0;
+}
+
+void kheap_stats(heap_stats_t *stats)
+{
+    heap_stats(heap, stats);
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <kernel/memory/heap.h>
+#include <kernel/memory/arena.h>
+#include <fs/initramdisk.h>
+
+#define REPORT_SIZE 0x1000
+
+static char report[REPORT_SIZE];
+static uint32_t report_length;
+
+static filesystem_node_t heapinfo_node;
+
+static void emit(const char *text)
+{
+    while(*text && report_length < REPORT_SIZE - 1)
+        report[report_length++] = *text++;
+}
+
+static void emit_number(uint32_t value)
+{
+    char digits[10];
+    int32_t count = 0;
+
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+
+    while(count-- && report_length < REPORT_SIZE - 1)
+        report[report_length++] = digits[count];
+}
+
+#ifdef HEAP_DEBUG
+static void emit_hex(uint32_t value)
+{
+    emit("0x");
+    for(int32_t shift = 28; shift >= 0 && report_length < REPORT_SIZE - 1; shift -= 4)
+        report[report_length++] = "0123456789abcdef"[(value >> shift) & 0xF];
+}
+#endif
+
+static void emit_field(const char *name, uint32_t value)
+{
+    emit(name);
+    emit(" ");
+    emit_number(value);
+    emit("\n");
+}
+
+// One "key value" pair per line so the output can be diffed or
+// scraped between samples taken hours apart.
+static void build_report()
+{
+    heap_stats_t stats;
+    kheap_stats(&stats);
+
+    report_length = 0;
+    emit_field("heap_size", stats.heap_size);
+    emit_field("bytes_in_use", stats.bytes_in_use);
+    emit_field("blocks_in_use", stats.blocks_in_use);
+    emit_field("free_bytes", stats.free_bytes);
+    emit_field("hole_count", stats.hole_count);
+    emit_field("largest_hole", stats.largest_hole);
+    emit_field("expand_count", stats.expand_count);
+    emit_field("contract_count", stats.contract_count);
+    emit_field("alloc_calls", stats.alloc_calls);
+    emit_field("free_calls", stats.free_calls);
+
+    for(uint32_t index = 0; index < HEAP_SIZE_CLASSES; ++index)
+    {
+        if(!stats.holes_by_class[index])
+            continue;
+
+        emit("holes ");
+        emit_number(0x1 << index);
+        emit(" ");
+        emit_number(stats.holes_by_class[index]);
+        emit("\n");
+    }
+
+    for(arena_t *arena = arenas; arena; arena = arena->next)
+    {
+        emit("arena ");
+        emit(arena->name);
+        emit(" ");
+        emit_number(arena->capacity);
+        emit(" ");
+        emit_number(arena->high_water);
+        emit(" ");
+        emit_number(arena->resets);
+        emit("\n");
+    }
+
+#ifdef HEAP_DEBUG
+    for(uint32_t index = 0; index < HEAP_SITES; ++index)
+    {
+        if(!heap_sites[index].caller)
+            continue;
+
+        emit("site ");
+        emit_hex(heap_sites[index].caller);
+        emit(" ");
+        emit_number(heap_sites[index].allocations);
+        emit(" ");
+        emit_number(heap_sites[index].bytes);
+        emit("\n");
+    }
+
+    emit_field("sites_dropped", heap_sites_dropped);
+#endif
+
+    heapinfo_node.length = report_length;
+}
+
+static uint32_t heapinfo_read(filesystem_node_t *node, uint32_t offset, uint32_t size, uint8_t *buffer)
+{
+    // A read from the start takes a fresh snapshot; continuing reads
+    // page through the same one so a reader never sees it torn.
+    if(offset == 0)
+        build_report();
+
+    if(offset >= report_length)
+        return 0;
+
+    if(offset + size > report_length)
+        size = report_length - offset;
+
+    for(uint32_t i = 0; i < size; ++i)
+        buffer[i] = report[offset + i];
+
+    return size;
+}
+
+void init_heapinfo()
+{
+    strcpy(heapinfo_node.name, "heapinfo");
+    heapinfo_node.flags = FS_CHARDEVICE;
+    heapinfo_node.read = &heapinfo_read;
+
+    initramdisk_add_device(&heapinfo_node);
+}
\ No newline at end of file
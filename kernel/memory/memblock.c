@@ -0,0 +1,193 @@
+#include <kernel/memory/memblock.h>
+#include <kernel/memory/buddy.h>
+
+#include <panic.h>
+
+static memblock_type_t memory;
+static memblock_type_t reserved;
+static uint32_t limit = 0xFFFFFFFF;
+static int32_t retired = 0;
+
+static void insert_region(memblock_type_t *type, uint32_t base, uint32_t end)
+{
+    if(end <= base)
+        return;
+
+    uint32_t i = 0;
+    while(i < type->count && type->regions[i].end < base)
+        ++i;
+
+    /* Swallow every region the new range overlaps or touches */
+    uint32_t last = i;
+    while(last < type->count && type->regions[last].base <= end)
+    {
+        if(type->regions[last].base < base)
+            base = type->regions[last].base;
+        if(type->regions[last].end > end)
+            end = type->regions[last].end;
+        ++last;
+    }
+
+    if(last == i && type->count == MEMBLOCK_MAX_REGIONS)
+        PANIC("Too many memblock regions");
+
+    uint32_t removed = last - i;
+    if(removed == 0)
+    {
+        for(uint32_t j = type->count; j > i; --j)
+            type->regions[j] = type->regions[j - 1];
+        ++type->count;
+    }
+    else
+    {
+        for(uint32_t j = i + 1; j + removed - 1 < type->count; ++j)
+            type->regions[j] = type->regions[j + removed - 1];
+        type->count -= removed - 1;
+    }
+
+    type->regions[i].base = base;
+    type->regions[i].end = end;
+}
+
+static uint32_t region_end(multiboot_memory_map_t *map)
+{
+    uint32_t end = map->base_low + map->length_low;
+
+    if(map->length_high || end < map->base_low)
+        end = 0xFFFFF000;
+
+    return end & 0xFFFFF000;
+}
+
+void memblock_init(multiboot_header_t *mboot, uint32_t kernel_end, uint32_t stack)
+{
+    if(mboot->flags & MULTIBOOT_FLAG_MMAP)
+    {
+        uint32_t entry = mboot->mmap_addr;
+        while(entry < mboot->mmap_addr + mboot->mmap_length)
+        {
+            multiboot_memory_map_t *map = (multiboot_memory_map_t*) entry;
+
+            if(map->type == MULTIBOOT_MEMORY_AVAILABLE && map->base_high == 0)
+                insert_region(&memory, (map->base_low + 0xFFF) & 0xFFFFF000, region_end(map));
+
+            entry += map->size + sizeof(map->size);
+        }
+
+        memblock_reserve(mboot->mmap_addr, mboot->mmap_length);
+    }
+    else if(mboot->flags & MULTIBOOT_FLAG_MEM)
+    {
+        memblock_add(0, mboot->mem_lower * 1024);
+        memblock_add(MEMBLOCK_LOW_LIMIT, mboot->mem_upper * 1024);
+    }
+
+    if(memory.count == 0)
+        memblock_add(MEMBLOCK_LOW_LIMIT, 0x1000000 - MEMBLOCK_LOW_LIMIT);
+
+    /* The null page, the kernel image with its modules, and what the boot loader handed over */
+    memblock_reserve(0, 0x1000);
+    memblock_reserve(MEMBLOCK_LOW_LIMIT, kernel_end - MEMBLOCK_LOW_LIMIT);
+    memblock_reserve((uint32_t) mboot, sizeof(multiboot_header_t));
+    memblock_reserve(stack - MEMBLOCK_STACK_RESERVE, MEMBLOCK_STACK_RESERVE + 0x1000);
+
+    if(mboot->flags & MULTIBOOT_FLAG_MODS)
+        memblock_reserve(mboot->mods_addr, mboot->mods_count * 16);
+}
+
+void memblock_add(uint32_t base, uint32_t size)
+{
+    insert_region(&memory, base, base + size);
+}
+
+void memblock_reserve(uint32_t base, uint32_t size)
+{
+    insert_region(&reserved, base & 0xFFFFF000, (base + size + 0xFFF) & 0xFFFFF000);
+}
+
+uint32_t memblock_alloc_range(uint32_t size, uint32_t align, uint32_t start, uint32_t end)
+{
+    if(retired)
+        PANIC("memblock used after handoff");
+
+    if(align < 0x4)
+        align = 0x4;
+
+    for(uint32_t i = 0; i < memory.count; ++i)
+    {
+        uint32_t base = memory.regions[i].base > start ? memory.regions[i].base : start;
+        uint32_t top = memory.regions[i].end < end ? memory.regions[i].end : end;
+
+        base = (base + align - 1) & ~(align - 1);
+
+        for(uint32_t r = 0; r < reserved.count && base + size <= top; ++r)
+        {
+            if(reserved.regions[r].end <= base || reserved.regions[r].base >= base + size)
+                continue;
+
+            base = (reserved.regions[r].end + align - 1) & ~(align - 1);
+        }
+
+        if(base >= start && base + size <= top && base + size > base)
+        {
+            memblock_reserve(base, size);
+            return base;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t memblock_alloc(uint32_t size, uint32_t align)
+{
+    uint32_t address = memblock_alloc_range(size, align, MEMBLOCK_LOW_LIMIT, limit);
+
+    if(!address)
+        PANIC("Out of early memory");
+
+    return address;
+}
+
+void memblock_set_limit(uint32_t new_limit)
+{
+    limit = new_limit;
+}
+
+uint32_t memblock_memory_end()
+{
+    return memory.count ? memory.regions[memory.count - 1].end : 0;
+}
+
+uint32_t memblock_reserved_end()
+{
+    return reserved.count ? reserved.regions[reserved.count - 1].end : 0;
+}
+
+/* Every page of RAM that was never reserved goes to the buddy allocator, early gaps included */
+void memblock_free_all()
+{
+    uint32_t r = 0;
+
+    for(uint32_t i = 0; i < memory.count; ++i)
+    {
+        uint32_t base = memory.regions[i].base;
+        uint32_t end = memory.regions[i].end;
+
+        while(base < end)
+        {
+            while(r < reserved.count && reserved.regions[r].end <= base)
+                ++r;
+
+            uint32_t top = end;
+            if(r < reserved.count && reserved.regions[r].base < top)
+                top = reserved.regions[r].base;
+
+            if(top > base)
+                buddy_free_range(base / 0x1000, (top - base) / 0x1000);
+
+            base = r < reserved.count && reserved.regions[r].base < end ? reserved.regions[r].end : end;
+        }
+    }
+
+    retired = 1;
+}
\ No newline at end of file
@@ -1,69 +1,192 @@
 #include <kernel/memory/paging.h>
 #include <kernel/memory/heap.h>
+#include <kernel/memory/buddy.h>
+#include <kernel/memory/frame.h>
+#include <kernel/memory/memblock.h>
+#include <kernel/memory/reclaim.h>
+#include <kernel/memory/swap.h>
+#include <kernel/memory/vma.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/task.h>
 
 page_directory_t *kernel_directory = 0;
 page_directory_t *current_directory = 0;
 
-uint32_t *frames;
-uint32_t number_of_frames;
-
-extern uint32_t placement_address;
 extern heap_t *heap;
 
-static void set_frame(uint32_t frame_addr)
+extern void fast_copy_page(void *destination, void *source);
+extern void fast_zero_page(void *destination);
+
+static vm_area_t heap_area;
+static heap_t kernel_heap;
+static int32_t large_pages = 0;
+static int32_t global_pages = 0;
+static page_table_t *kmap_table = 0;
+
+static uint32_t zero_pool[ZERO_POOL_SIZE];
+static uint32_t zero_pool_count = 0;
+static wait_queue_t zero_pool_waiters;
+
+static void enable_cr4(uint32_t bits)
+{
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= bits;
+    asm volatile("mov %0, %%cr4" :: "r"(cr4));
+}
+
+static void disable_cr4(uint32_t bits)
 {
-    uint32_t frame = frame_addr / 0x1000;
-    uint32_t index = INDEX_FROM_BIT(frame);
-    uint32_t offset = OFFSET_FROM_BIT(frame);
-    frames[index] |= 0x1 << offset;
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 &= ~bits;
+    asm volatile("mov %0, %%cr4" :: "r"(cr4));
 }
 
-static void clear_frame(uint32_t frame_addr)
+static void map_large_page(page_directory_t *dir, uint32_t address, uint32_t frame, uint32_t flags)
 {
-    uint32_t frame = frame_addr / 0x1000;
-    uint32_t index = INDEX_FROM_BIT(frame);
-    uint32_t offset = OFFSET_FROM_BIT(frame);
-    frames[index] &= ~(0x1 << offset);
+    uint32_t table_index = address / LARGE_PAGE_SIZE;
+    dir->tables[table_index] = 0;
+    dir->tablesPhysical[table_index] = (frame * 0x1000) | flags | PDE_LARGE | PDE_PRESENT;
 }
 
-static uint32_t set_frame(uint32_t frame_addr)
+static void set_page(page_t *page, uint32_t frame, int32_t is_kernel, int32_t is_writable)
 {
-    uint32_t frame = frame_addr / 0x1000;
-    uint32_t index = INDEX_FROM_BIT(frame);
-    uint32_t offset = OFFSET_FROM_BIT(frame);
-    return (frames[index] & (0x1 << offset));
+    page->present = 1;
+    page->rw = is_writable == 1 ? 1 : 0;
+    page->user = is_kernel == 1 ? 1 : 0;
+    page->frame = frame;
+    page_frames[frame].refcount = 1;
+    page_frames[frame].flags = 0;
 }
 
-static uint32_t first_frame()
+static uint32_t zero_pool_take()
 {
-    for(uint32_t i = 0; i < INDEX_FROM_BIT(number_of_frames); ++i)
+    uint32_t flags;
+    uint32_t index = BUDDY_NONE;
+
+    IRQ_SAVE(flags);
+    if(zero_pool_count)
+        index = zero_pool[--zero_pool_count];
+    if(zero_pool_count < ZERO_POOL_LOW)
+        task_wake_up(&zero_pool_waiters);
+    IRQ_RESTORE(flags);
+
+    return index;
+}
+
+uint32_t zero_pool_refill(uint32_t budget)
+{
+    uint32_t zeroed = 0;
+
+    while(zeroed < budget && zero_pool_count < ZERO_POOL_SIZE)
     {
-        if(frames[i] != 0xFFFFF000)
+        uint32_t index = buddy_alloc(0);
+        if(index == BUDDY_NONE)
+            break;
+
+        zero_page_physical(index * 0x1000);
+
+        uint32_t flags;
+        IRQ_SAVE(flags);
+        if(zero_pool_count < ZERO_POOL_SIZE)
         {
-            for(uint32_t j = 0; j < 32; ++j)
-            {
-                uint32_t test = 0x1 << j;
-                if(!(frames[i] & test))
-                    return i * 4 * 8 + j;
-            }
+            zero_pool[zero_pool_count++] = index;
+            index = BUDDY_NONE;
+        }
+        IRQ_RESTORE(flags);
+
+        if(index != BUDDY_NONE)
+        {
+            buddy_free(index, 0);
+            break;
         }
+
+        ++zeroed;
     }
+
+    return zeroed;
 }
 
-void alloc_frame(page_t *page,int32_t is_kernel, int32_t is_writable)
+// Keeps the pool topped up in the background at the lowest priority, and
+// sleeps once it is full or memory is too short to refill it.
+static void zero_pool_thread(void *arg)
+{
+    task_set_nice((task_t*) current_task, NICE_MAX);
+
+    for(;;)
+    {
+        if(!zero_pool_refill(ZERO_POOL_BATCH))
+        {
+            uint32_t flags;
+            IRQ_SAVE(flags);
+            task_sleep_on(&zero_pool_waiters);
+            IRQ_RESTORE(flags);
+        }
+
+        if(need_resched)
+            task_yield();
+    }
+}
+
+void zero_pool_start()
+{
+    wait_queue_init(&zero_pool_waiters, 0);
+    kthread_create(&zero_pool_thread, 0);
+}
+
+/* Called from faults that may have been taken inside the heap or slab, so
+   the synchronous path only writes to disk swap; compressing into zram
+   allocates and is left to kswapd */
+static uint32_t frame_or_reclaim()
+{
+    uint32_t index = buddy_alloc(0);
+
+    if(index == BUDDY_NONE)
+    {
+        reclaim_wake();
+
+        if(reclaim_pages(SWAP_CLUSTER, RECLAIM_NOALLOC))
+            index = buddy_alloc(0);
+    }
+
+    return index;
+}
+
+void alloc_frame_flags(page_t *page, int32_t is_kernel, int32_t is_writable, uint32_t flags)
 {
     if(page->frame != 0)
         return;
 
-    uint32_t index = first_frame();
-    if(index == (uint32_t) -1)
-        PANIC("No free frames");
+    uint32_t index = (flags & FRAME_ZERO) ? zero_pool_take() : BUDDY_NONE;
 
-    set_frame(index * 0x1000);
-    page->present = 1;
-    page->rw = is_writable == 1 ? 1 : 0;
-    page->user = is_kernel == 1 ? 1 : 0;
-    page->frame = index;
+    if(index == BUDDY_NONE)
+    {
+        index = buddy_alloc(0);
+
+        if(index == BUDDY_NONE && (index = zero_pool_take()) != BUDDY_NONE)
+            flags &= ~FRAME_ZERO;
+
+        if(index == BUDDY_NONE)
+            index = frame_or_reclaim();
+
+        if(index == BUDDY_NONE)
+            PANIC("No free frames");
+
+        if(flags & FRAME_ZERO)
+            zero_page_physical(index * 0x1000);
+    }
+
+    set_page(page, index, is_kernel, is_writable);
+
+    /* Reclaim ahead of exhaustion so compressed swap still has frames to grow its pool into */
+    if(buddy_free_frames() < RECLAIM_WATERMARK)
+        reclaim_wake();
+}
+
+void alloc_frame(page_t *page,int32_t is_kernel, int32_t is_writable)
+{
+    alloc_frame_flags(page, is_kernel, is_writable, 0);
 }
 
 void free_frame(page_t *page)
@@ -72,51 +195,118 @@ void free_frame(page_t *page)
     if(!(frame = page->frame))
         return;
 
-    clear_frame(frame);
+    if(page->swapped)
+    {
+        swap_free(frame);
+        page->swapped = 0;
+        page->frame = 0x0;
+        return;
+    }
+
+    if(frame_put(frame) == 0)
+    {
+        lru_remove(frame);
+        buddy_free(frame, 0);
+    }
+
+    page->present = 0;
     page->frame = 0x0;
 }
 
 void init_paging()
 {
-    uint32_t memory_end_page = 0x1000000;
-    number_of_frames = memory_end_page / 0x1000;
-    frames = (uint32_t*) kmalloc(INDEX_FROM_BIT(number_of_frames));
-    memset(frames, 0, INDEX_FROM_BIT(number_of_frames));
+    frame_table_init(memblock_memory_end() / 0x1000);
+    buddy_init();
 
-    uint32_t phys;
-    kernel_directory = (page_directory_t*) kmalloc_a(sizeof(page_directory_t));
+    kernel_directory = (page_directory_t*) memblock_alloc(sizeof(page_directory_t), 0x1000);
     memset(kernel_directory, 0, sizeof(page_directory_t));
     kernel_directory->physicalAddr = (uint32_t) kernel_directory->tablesPhysical;
 
-    for(int32_t i = HEAP_START; i < HEAP_START + HEAP_INITIAL_SIZE; i += 0x1000)
-        get_page(i, 1, kernel_directory);
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(1, eax, ebx, ecx, edx);
+    large_pages = (edx & CPUID_EDX_PSE) ? 1 : 0;
+    global_pages = (edx & CPUID_EDX_PGE) ? 1 : 0;
+
+    uint32_t global = global_pages ? PDE_GLOBAL : 0;
+
+    get_page(KMAP_BASE, 1, kernel_directory);
+    kmap_table = kernel_directory->tables[KMAP_BASE / LARGE_PAGE_SIZE];
 
-    int32_t i = 0;
-    while(i < 0x400000)
+    if(large_pages)
+        enable_cr4(CR4_PSE);
+
+    /* Writable: the kernel image, boot stack and VGA memory all live here,
+       and CR0.WP makes the supervisor honour the read-only bit too */
+    uint32_t identity_end = 0;
+    while(identity_end < memblock_reserved_end() + IDENTITY_SLACK)
     {
-        alloc_frame(get_page(i, 1, kernel_directory), 0, 0);
-        i += 0x1000;
+        if(large_pages)
+            map_large_page(kernel_directory, identity_end, identity_end / 0x1000, PDE_WRITE | global);
+        else
+            vmm_map_range(kernel_directory, identity_end, LARGE_PAGE_SIZE, identity_end, VMM_WRITE | (global_pages ? VMM_GLOBAL : 0));
+
+        identity_end += LARGE_PAGE_SIZE;
     }
 
-    for (i = HEAP_START; i < HEAP_START + HEAP_INITIAL_SIZE; i += 0x1000)
-        alloc_frame(get_page(i, 1, kernel_directory), 0, 0);
+    /* Early allocations from here on must stay inside the identity map */
+    memblock_set_limit(identity_end);
 
-    register_interrput_handler(14, page_fault);
+    uint32_t heap_frame = large_pages ? memblock_alloc_range(LARGE_PAGE_SIZE, LARGE_PAGE_SIZE, identity_end, memblock_memory_end()) : 0;
+
+    if(heap_frame)
+        map_large_page(kernel_directory, HEAP_START, heap_frame / 0x1000, PDE_WRITE | global);
+    else
+        vmm_reserve_range(kernel_directory, HEAP_START, HEAP_INITIAL_SIZE);
+
+    heap_area.start = HEAP_START;
+    heap_area.end = HEAP_MAX;
+    heap_area.flags = VMA_WRITE;
+    vma_insert(kernel_directory, &heap_area);
+
+    register_interrupt_handler(14, page_fault);
     switch_page_directory(kernel_directory);
 
-    heap = create_heap(HEAP_START, HEAP_START + HEAP_INITIAL_SIZE, 0xCFFFF000, 0, 0);
+    if(global_pages)
+        enable_cr4(CR4_PGE);
+
+    memblock_free_all();
+
+    init_heap(&kernel_heap, HEAP_START, HEAP_START + HEAP_INITIAL_SIZE, HEAP_MAX, 0, 0);
+    heap = &kernel_heap;
 
     current_directory = clone_directory(kernel_directory);
     switch_page_directory(current_directory);
 }
 
+void flush_tlb_range(page_directory_t *dir, uint32_t start, uint32_t size)
+{
+    if(dir != current_directory && dir != kernel_directory)
+        return;
+
+    uint32_t pages = (size + 0xFFF) / 0x1000;
+
+    if(pages <= TLB_FLUSH_THRESHOLD)
+    {
+        for(uint32_t i = 0; i < pages; ++i)
+            INVLPG(start + i * 0x1000);
+    }
+    else if(global_pages)
+    {
+        disable_cr4(CR4_PGE);
+        enable_cr4(CR4_PGE);
+    }
+    else
+        switch_page_directory(current_directory);
+}
+
 void switch_page_directory(page_directory_t *newDir)
 {
     current_directory = newDir;
     asm volatile("mov %0, %%cr3":: "r"(newDir->physicalAddr));
     uint32_t cr0;
     asm volatile("mov %%cr0, %0": "=r"(cr0));
-    cr0 |= 0x80000000;
+    // PG, plus WP so kernel writes also fault on read-only and COW pages
+    cr0 |= 0x80010000;
     asm volatile("mov %0, %%cr0":: "r"(cr0));
 }
 
@@ -125,34 +315,231 @@ page_t *get_page(uint32_t address, int32_t make, page_directory_t *dir)
     address /= 0x1000;
     uint32_t table_index = address / 1024;
 
+    if (dir->tablesPhysical[table_index] & PDE_LARGE)
+        return 0;
+
     if (dir->tables[table_index])
         return &dir->tables[table_index]->pages[address%1024];
     else if(make)
     {
         uint32_t tmp;
-        dir->tables[table_index] = (page_table_t*) kmalloc_ap(sizeof(page_table_t), &tmp);
-        memset(dir->tables[table_index], 0, 0x1000);
+        if(heap)
+            dir->tables[table_index] = (page_table_t*) kmalloc_ap(sizeof(page_table_t), &tmp);
+        else
+            dir->tables[table_index] = (page_table_t*) (tmp = memblock_alloc(sizeof(page_table_t), 0x1000));
+
+        fast_zero_page(dir->tables[table_index]);
         dir->tablesPhysical[table_index] = tmp | 0x7;
         return &dir->tables[table_index]->pages[address % 1024];
     }
     else return 0;
 }
 
+void *kmap_slot(uint32_t slot, uint32_t frame)
+{
+    uint32_t address = KMAP_BASE + slot * 0x1000;
+    page_t *page = &kmap_table->pages[slot];
+
+    page->present = 1;
+    page->rw = 1;
+    page->frame = frame;
+    INVLPG(address);
+    return (void*) address;
+}
+
+void kunmap_slot(uint32_t slot)
+{
+    kmap_table->pages[slot].present = 0;
+    kmap_table->pages[slot].frame = 0;
+    INVLPG(KMAP_BASE + slot * 0x1000);
+}
+
+void copy_page_physical(uint32_t source, uint32_t destination)
+{
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    void *from = kmap_slot(KMAP_SOURCE, source / 0x1000);
+    void *to = kmap_slot(KMAP_DESTINATION, destination / 0x1000);
+    fast_copy_page(to, from);
+    kunmap_slot(KMAP_DESTINATION);
+    kunmap_slot(KMAP_SOURCE);
+
+    IRQ_RESTORE(flags);
+}
+
+void zero_page_physical(uint32_t address)
+{
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    fast_zero_page(kmap_slot(KMAP_DESTINATION, address / 0x1000));
+    kunmap_slot(KMAP_DESTINATION);
+
+    IRQ_RESTORE(flags);
+}
+
+static void resolve_copy_on_write(page_t *page, uint32_t address)
+{
+    uint32_t frame = page->frame;
+
+    if(page_frames[frame].refcount > 1)
+    {
+        uint32_t index = frame_or_reclaim();
+        if(index == BUDDY_NONE)
+            PANIC("No free frames");
+
+        copy_page_physical(frame * 0x1000, index * 0x1000);
+        frame_put(frame);
+        page_frames[index].refcount = 1;
+        page_frames[index].flags = 0;
+        page->frame = index;
+    }
+
+    if(page->user)
+        lru_add(page->frame, page);
+
+    page->rw = 1;
+    page->cow = 0;
+    INVLPG(address & 0xFFFFF000);
+}
+
+uint32_t get_physical_address(uint32_t address, page_directory_t *dir)
+{
+    uint32_t table_index = address / LARGE_PAGE_SIZE;
+
+    if (dir->tablesPhysical[table_index] & PDE_LARGE)
+        return (dir->tablesPhysical[table_index] & ~(LARGE_PAGE_SIZE - 1)) + (address & (LARGE_PAGE_SIZE - 1));
+
+    page_t *page = get_page(address, 0, dir);
+    return page->frame * 0x1000 + (address & 0xFFF);
+}
+
+static int32_t resolve_demand_fault(uint32_t address)
+{
+    page_directory_t *dir = current_directory;
+    vm_area_t *area = vma_find(dir, address);
+
+    if(!area)
+    {
+        dir = kernel_directory;
+        area = vma_find(dir, address);
+    }
+
+    if(!area)
+        return 0;
+
+    uint32_t table_index = address / 0x1000 / 1024;
+    page_t *page = get_page(address, 1, dir);
+    if(!page)
+        return 0;
+
+    if(dir != current_directory && current_directory->tables[table_index] != dir->tables[table_index])
+    {
+        current_directory->tables[table_index] = dir->tables[table_index];
+        current_directory->tablesPhysical[table_index] = dir->tablesPhysical[table_index];
+    }
+
+    if(!page->present)
+    {
+        alloc_frame_flags(page, 0, (area->flags & VMA_WRITE) ? 1 : 0, FRAME_ZERO);
+        page->user = (area->flags & VMA_USER) ? 1 : 0;
+        page->global = (dir == kernel_directory) ? global_pages : 0;
+
+        if(page->user)
+            lru_add(page->frame, page);
+    }
+
+    return 1;
+}
+
+static void resolve_swap_fault(page_t *page)
+{
+    uint32_t entry = page->frame;
+    uint32_t index = frame_or_reclaim();
+
+    if(index == BUDDY_NONE)
+        PANIC("No free frames");
+
+    if(swap_read(entry, index) < 0)
+        PANIC("Swap read failed");
+
+    page_frames[index].refcount = 1;
+    page_frames[index].flags = 0;
+
+    page->swapped = 0;
+    page->accessed = 0;
+    page->dirty = 0;
+    page->frame = index;
+    page->present = 1;
+
+    swap_free(entry);
+    lru_add(index, page);
+}
+
 void page_fault(registers_t *regs)
 {
+    uint32_t address;
+    asm volatile("mov %%cr2, %0" : "=r"(address));
+
+    if((regs->err_code & PAGE_FAULT_PRESENT) && (regs->err_code & PAGE_FAULT_WRITE))
+    {
+        page_t *page = get_page(address, 0, current_directory);
+
+        if(page && page->cow)
+        {
+            resolve_copy_on_write(page, address);
+            return;
+        }
+    }
+
+    if(!(regs->err_code & PAGE_FAULT_PRESENT))
+    {
+        page_t *page = get_page(address, 0, current_directory);
+
+        if(page && page->swapped)
+        {
+            resolve_swap_fault(page);
+            return;
+        }
+
+        if(resolve_demand_fault(address))
+            return;
+    }
+
     PANIC("Page fault");
 }
 
 static page_table_t *clone_table(page_table_t *src, uint32_t *physAddr)
 {
     page_table_t *table = (page_table_t*) kmalloc_ap(sizeof(page_table_t), physAddr);
-    memset(table, 0, sizeof(page_directory_t));
+    memset(table, 0, sizeof(page_table_t));
 
     for (int32_t i = 0; i < 1024; ++i)
     {
         if (!src->pages[i].frame)
             continue;
 
+        if (src->pages[i].swapped)
+        {
+            table->pages[i] = src->pages[i];
+            swap_duplicate(src->pages[i].frame);
+            continue;
+        }
+
+        if (src->pages[i].present && src->pages[i].user)
+        {
+            if (src->pages[i].rw)
+            {
+                src->pages[i].rw = 0;
+                src->pages[i].cow = 1;
+            }
+
+            table->pages[i] = src->pages[i];
+            frame_get(src->pages[i].frame);
+            continue;
+        }
+
         alloc_frame(&table->pages[i], 0, 0);
         if(src->pages[i].present)
             table->pages[i].present = 1;
@@ -172,15 +559,22 @@ static page_table_t *clone_table(page_table_t *src, uint32_t *physAddr)
 
 page_directory_t *clone_directory(page_directory_t *src)
 {
-    uint32_t phys;
-    page_directory_t *dir = (page_directory_t*) kmalloc_ap(sizeof(page_directory_t), &phys);
+    page_directory_t *dir = (page_directory_t*) kmalloc_a(sizeof(page_directory_t));
     memset(dir, 0, sizeof(page_directory_t));
 
-    uint32_t offset = (uint32_t) dir->tablesPhysical - (uint32_t)dir;
-    dir->physicalAddr = phys + offset;
+    /* The heap is demand-paged, so tablesPhysical need not sit in the
+       frame after the first one: fault it in and look it up */
+    *(volatile uint32_t*) dir->tablesPhysical;
+    dir->physicalAddr = get_physical_address((uint32_t) dir->tablesPhysical, kernel_directory);
 
     for (int32_t i = 0; i < 1024; ++i)
     {
+        if (src->tablesPhysical[i] & PDE_LARGE)
+        {
+            dir->tablesPhysical[i] = src->tablesPhysical[i];
+            continue;
+        }
+
         if (!src->tables[i])
             continue;
 
@@ -196,5 +590,12 @@ page_directory_t *clone_directory(page_directory_t *src)
             dir->tablesPhysical[i] = phys | 0x07;
         }
     }
+
+    if (src != kernel_directory)
+        vma_clone(src, dir);
+
+    if (src == current_directory)
+        switch_page_directory(current_directory);
+
     return dir;
 }
\ No newline at end of file
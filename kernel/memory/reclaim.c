@@ -0,0 +1,243 @@
+#include <kernel/memory/reclaim.h>
+#include <kernel/memory/frame.h>
+#include <kernel/memory/buddy.h>
+#include <kernel/memory/swap.h>
+#include <kernel/memory/heap.h>
+#include <kernel/task.h>
+
+#include <asm/system.h>
+
+extern void fast_copy_page(void *destination, void *source);
+
+/* Two-list LRU of anonymous user frames, aged with the PTE accessed bit */
+static frame_list_t active;
+static frame_list_t inactive;
+static uint8_t *cluster_buffer = 0;
+static int32_t reclaiming = 0;
+static uint32_t reclaim_exclude = 0;
+static wait_queue_t kswapd_waiters;
+
+void reclaim_init()
+{
+    if(cluster_buffer)
+        return;
+
+    frame_list_init(&active);
+    frame_list_init(&inactive);
+
+    /* Fault the bounce buffer in now, reclaim runs exactly when no frame is left to back it */
+    cluster_buffer = (uint8_t*) kmalloc_a(SWAP_CLUSTER * 0x1000);
+    for(uint32_t i = 0; i < SWAP_CLUSTER; ++i)
+        cluster_buffer[i * 0x1000] = 0;
+}
+
+void lru_add(uint32_t frame, page_t *page)
+{
+    page_frame_t *descriptor = &page_frames[frame];
+    descriptor->mapping = page;
+
+    if(!cluster_buffer || (descriptor->flags & PF_LRU))
+        return;
+
+    descriptor->flags |= PF_LRU;
+    frame_list_push(&inactive, frame);
+}
+
+void lru_remove(uint32_t frame)
+{
+    page_frame_t *descriptor = &page_frames[frame];
+
+    if(descriptor->flags & PF_LRU)
+        frame_list_remove((descriptor->flags & PF_ACTIVE) ? &active : &inactive, frame);
+
+    descriptor->flags &= ~(PF_LRU | PF_ACTIVE);
+    descriptor->mapping = 0;
+}
+
+static void activate(uint32_t frame)
+{
+    page_frames[frame].flags |= PF_ACTIVE;
+    frame_list_push(&active, frame);
+    ++swap_stats.activated;
+}
+
+static void deactivate()
+{
+    uint32_t frame = frame_list_pop_tail(&active);
+    if(frame == FRAME_NONE)
+        return;
+
+    page_t *page = page_frames[frame].mapping;
+    if(page)
+        page->accessed = 0;
+
+    page_frames[frame].flags &= ~PF_ACTIVE;
+    frame_list_push(&inactive, frame);
+}
+
+static uint32_t write_cluster(uint32_t *frames, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        fast_copy_page(cluster_buffer + i * 0x1000, kmap_slot(KMAP_SOURCE, frames[i]));
+        kunmap_slot(KMAP_SOURCE);
+    }
+
+    /* A device that refuses the cluster drops out and the next tier is tried */
+    uint32_t exclude = reclaim_exclude;
+    uint32_t entry;
+
+    while((entry = swap_alloc(count, exclude)) != 0 && swap_write(entry, count, cluster_buffer) < 0)
+    {
+        for(uint32_t i = 0; i < count; ++i)
+            swap_free(entry + i);
+
+        exclude |= 0x1 << SWAP_DEVICE(entry);
+        ++swap_stats.write_errors;
+    }
+
+    if(!entry)
+        return 0;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        page_t *page = page_frames[frames[i]].mapping;
+        page->present = 0;
+        page->swapped = 1;
+        page->frame = entry + i;
+
+        page_frames[frames[i]].mapping = 0;
+        page_frames[frames[i]].flags &= ~PF_LRU;
+        if(frame_put(frames[i]) == 0)
+            buddy_free(frames[i], 0);
+    }
+
+    ++swap_stats.clusters;
+    swap_stats.pages_out += count;
+    return count;
+}
+
+/* Writes as many slots contiguously as the devices allow, halving the cluster when they are fragmented */
+static uint32_t swap_out(uint32_t *frames, uint32_t count)
+{
+    uint32_t written = 0;
+
+    while(written < count)
+    {
+        uint32_t batch = count - written;
+        uint32_t done = 0;
+
+        while(batch && !(done = write_cluster(frames + written, batch)))
+            batch /= 2;
+
+        if(!done)
+            break;
+
+        written += done;
+    }
+
+    for(uint32_t i = written; i < count; ++i)
+        activate(frames[i]);
+
+    return written;
+}
+
+uint32_t reclaim_pages(uint32_t target, uint32_t mode)
+{
+    if(!cluster_buffer || reclaiming || swap_free_slots() == 0)
+        return 0;
+
+    uint32_t flags;
+    IRQ_SAVE(flags);
+    reclaiming = 1;
+    reclaim_exclude = (mode & RECLAIM_NOALLOC) ? swap_allocating_devices() : 0;
+
+    uint64_t start;
+    RDTSC(start);
+    uint32_t victims[SWAP_CLUSTER];
+    uint32_t victim_count = 0;
+    uint32_t reclaimed = 0;
+    uint32_t budget = 2 * (active.count + inactive.count);
+
+    while(reclaimed + victim_count < target && budget--)
+    {
+        if(inactive.count <= active.count)
+            deactivate();
+
+        uint32_t frame = frame_list_pop_tail(&inactive);
+        if(frame == FRAME_NONE)
+            break;
+
+        ++swap_stats.scanned;
+
+        /* The single mapping recorded for a frame is only trusted while it still points back at it */
+        page_t *page = page_frames[frame].mapping;
+        if(!page || !page->present || page->frame != frame)
+        {
+            page_frames[frame].flags &= ~PF_LRU;
+            page_frames[frame].mapping = 0;
+            continue;
+        }
+
+        if(page->accessed || page_frames[frame].refcount > 1 || (page_frames[frame].flags & PF_LOCKED))
+        {
+            page->accessed = 0;
+            activate(frame);
+            continue;
+        }
+
+        victims[victim_count++] = frame;
+        if(victim_count == SWAP_CLUSTER)
+        {
+            reclaimed += swap_out(victims, victim_count);
+            victim_count = 0;
+        }
+    }
+
+    if(victim_count)
+        reclaimed += swap_out(victims, victim_count);
+
+    /* Evicted PTEs and cleared accessed bits must not linger in the TLB */
+    asm volatile("mov %%cr3, %%eax\n mov %%eax, %%cr3" ::: "eax", "memory");
+
+    swap_stats.reclaimed += reclaimed;
+    uint64_t end;
+    RDTSC(end);
+    swap_stats.reclaim_cycles += end - start;
+
+    reclaiming = 0;
+    IRQ_RESTORE(flags);
+    return reclaimed;
+}
+
+/* Watermark reclaim runs here rather than in alloc_frame_flags: a fault
+   taken inside halloc or kmem_cache_alloc would otherwise enter reclaim,
+   and through zram the slab and heap, with their lists half updated.
+   Only this thread may write to zram. */
+static void kswapd(void *arg)
+{
+    for(;;)
+    {
+        while(buddy_free_frames() < RECLAIM_WATERMARK && reclaim_pages(SWAP_CLUSTER, 0))
+        {
+            if(need_resched)
+                task_yield();
+        }
+
+        uint32_t flags;
+        IRQ_SAVE(flags);
+        task_sleep_on(&kswapd_waiters);
+        IRQ_RESTORE(flags);
+    }
+}
+
+void reclaim_wake()
+{
+    task_wake_up(&kswapd_waiters);
+}
+
+void reclaim_start()
+{
+    wait_queue_init(&kswapd_waiters, 0);
+    kthread_create(&kswapd, 0);
+}
\ No newline at end of file
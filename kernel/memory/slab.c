@@ -0,0 +1,173 @@
+#include <kernel/memory/slab.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/frame.h>
+
+#include <string.h>
+
+static void slab_list_add(slab_t **list, slab_t *slab)
+{
+    slab->prev = 0;
+    slab->next = *list;
+    if(*list)
+        (*list)->prev = slab;
+    *list = slab;
+}
+
+static void slab_list_remove(slab_t **list, slab_t *slab)
+{
+    if(slab->prev)
+        slab->prev->next = slab->next;
+    else
+        *list = slab->next;
+
+    if(slab->next)
+        slab->next->prev = slab->prev;
+}
+
+static void slab_release(kmem_cache_t *cache, slab_t *slab)
+{
+    page_frames[slab->frame].flags &= ~PF_SLAB;
+    --cache->slab_count;
+    kfree(slab);
+}
+
+static slab_t *slab_grow(kmem_cache_t *cache)
+{
+    uint32_t physical;
+    slab_t *slab = (slab_t*) kmalloc_ap(SLAB_SIZE, &physical);
+    slab->cache = cache;
+    slab->frame = physical / 0x1000;
+    page_frames[slab->frame].flags |= PF_SLAB;
+    slab->in_use = 0;
+    slab->free = 0;
+
+    uint32_t object = (uint32_t) slab + cache->object_offset;
+    for(uint32_t i = 0; i < cache->objects_per_slab; ++i)
+    {
+        *(void**) object = slab->free;
+        slab->free = (void*) object;
+        object += cache->object_size;
+    }
+
+    ++cache->slab_count;
+    slab_list_add(&cache->empty, slab);
+    return slab;
+}
+
+kmem_cache_t *kmem_cache_create(const char *name, uint32_t size, uint32_t align, kmem_ctor_t ctor)
+{
+    /* memset and memcpy in libc are empty stubs: set every field by hand */
+    kmem_cache_t *cache = (kmem_cache_t*) kmalloc(sizeof(kmem_cache_t));
+    cache->partial = 0;
+    cache->full = 0;
+    cache->empty = 0;
+    cache->slab_count = 0;
+    cache->active_objects = 0;
+
+    uint32_t length = 0;
+    for(; name[length] && length < SLAB_NAME_LENGTH - 1; ++length)
+        cache->name[length] = name[length];
+    for(; length < SLAB_NAME_LENGTH; ++length)
+        cache->name[length] = 0;
+
+    if(size < sizeof(void*))
+        size = sizeof(void*);
+
+    uint32_t line = CACHE_LINE_SIZE;
+    while(line > sizeof(void*) && line / 2 >= size)
+        line /= 2;
+
+    if(align < line)
+        align = line;
+
+    cache->object_size = (size + align - 1) & ~(align - 1);
+    cache->object_offset = (sizeof(slab_t) + align - 1) & ~(align - 1);
+    cache->objects_per_slab = (SLAB_SIZE - cache->object_offset) / cache->object_size;
+    cache->ctor = ctor;
+
+    if(cache->objects_per_slab == 0)
+        PANIC("Slab object too large");
+
+    return cache;
+}
+
+void *kmem_cache_alloc(kmem_cache_t *cache)
+{
+    slab_t *slab = cache->partial;
+
+    if(!slab)
+    {
+        slab = cache->empty;
+        if(!slab)
+            slab = slab_grow(cache);
+
+        slab_list_remove(&cache->empty, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+
+    void *object = slab->free;
+    slab->free = *(void**) object;
+    ++slab->in_use;
+    ++cache->active_objects;
+
+    if(slab->in_use == cache->objects_per_slab)
+    {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_add(&cache->full, slab);
+    }
+
+    if(cache->ctor)
+        cache->ctor(object);
+
+    return object;
+}
+
+void kmem_cache_free(kmem_cache_t *cache, void *object)
+{
+    if(object == 0)
+        return;
+
+    slab_t *slab = (slab_t*) ((uint32_t) object & ~(SLAB_SIZE - 1));
+    if(slab->cache != cache)
+        PANIC("Object freed to the wrong cache");
+
+    if(slab->in_use == cache->objects_per_slab)
+    {
+        slab_list_remove(&cache->full, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+
+    *(void**) object = slab->free;
+    slab->free = object;
+    --slab->in_use;
+    --cache->active_objects;
+
+    if(slab->in_use == 0)
+    {
+        slab_list_remove(&cache->partial, slab);
+
+        if(cache->empty)
+            slab_release(cache, slab);
+        else
+            slab_list_add(&cache->empty, slab);
+    }
+}
+
+void kmem_cache_shrink(kmem_cache_t *cache)
+{
+    while(cache->empty)
+    {
+        slab_t *slab = cache->empty;
+        slab_list_remove(&cache->empty, slab);
+        slab_release(cache, slab);
+    }
+}
+
+void kmem_cache_destroy(kmem_cache_t *cache)
+{
+    if(cache->active_objects)
+        PANIC("Destroying a cache with live objects");
+
+    kmem_cache_shrink(cache);
+    kfree(cache);
+}
\ No newline at end of file
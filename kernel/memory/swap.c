@@ -0,0 +1,210 @@
+#include <kernel/memory/swap.h>
+#include <kernel/memory/reclaim.h>
+#include <kernel/memory/heap.h>
+
+#include <drivers/ata.h>
+#include <asm/system.h>
+
+#define SWAP_SECTORS_PER_SLOT (0x1000 / ATA_SECTOR_SIZE)
+
+swap_stats_t swap_stats;
+
+static swap_device_t *devices[SWAP_MAX_DEVICES];
+static uint32_t device_count = 0;
+static swap_device_t disk_swap;
+
+static int32_t disk_read(swap_device_t *device, uint32_t slot, void *page)
+{
+    return ata_read((uint32_t) device->data, slot * SWAP_SECTORS_PER_SLOT, SWAP_SECTORS_PER_SLOT, page);
+}
+
+static int32_t disk_write(swap_device_t *device, uint32_t slot, uint32_t count, void *pages)
+{
+    return ata_write((uint32_t) device->data, slot * SWAP_SECTORS_PER_SLOT, count * SWAP_SECTORS_PER_SLOT, pages);
+}
+
+/* Only take over a disk that carries a mkswap header, never one holding a filesystem */
+static int32_t disk_has_signature(uint32_t drive)
+{
+    uint8_t *header = (uint8_t*) kmalloc(0x1000);
+    const char *signature = SWAP_SIGNATURE;
+    int32_t found = ata_read(drive, 0, SWAP_SECTORS_PER_SLOT, header) == 0;
+
+    for(uint32_t i = 0; found && signature[i]; ++i)
+        if(header[SWAP_SIGNATURE_OFFSET + i] != signature[i])
+            found = 0;
+
+    kfree(header);
+    return found;
+}
+
+void init_swap()
+{
+    init_ata();
+
+    ata_drive_t *drive = ata_drive(SWAP_ATA_DRIVE);
+    if(!drive || !disk_has_signature(SWAP_ATA_DRIVE))
+        return;
+
+    disk_swap.name = "ata";
+    disk_swap.slots = drive->sectors / SWAP_SECTORS_PER_SLOT;
+    disk_swap.priority = 0;
+    disk_swap.flags = 0;
+    disk_swap.read = disk_read;
+    disk_swap.write = disk_write;
+    disk_swap.release = 0;
+    disk_swap.data = (void*) SWAP_ATA_DRIVE;
+
+    swap_on(&disk_swap);
+}
+
+int32_t swap_on(swap_device_t *device)
+{
+    if(device_count == SWAP_MAX_DEVICES || device->slots < 2)
+        return -1;
+
+    if(device->slots > SWAP_MAX_SLOTS)
+        device->slots = SWAP_MAX_SLOTS;
+
+    device->slot_refs = (uint16_t*) kmalloc(sizeof(uint16_t) * device->slots);
+    for(uint32_t i = 0; i < device->slots; ++i)
+        device->slot_refs[i] = 0;
+
+    /* Slot 0 holds the swap header and keeps entries non-zero */
+    device->slot_refs[0] = SWAP_MAX_REFS;
+    device->used = 1;
+    device->cursor = 1;
+
+    reclaim_init();
+    devices[device_count++] = device;
+    return 0;
+}
+
+static uint32_t device_alloc(swap_device_t *device, uint32_t count)
+{
+    uint32_t run = 0;
+    uint32_t slot = device->cursor;
+
+    for(uint32_t scanned = 0; scanned < device->slots; ++scanned, ++slot)
+    {
+        if(slot == device->slots)
+        {
+            slot = 1;
+            run = 0;
+        }
+
+        run = device->slot_refs[slot] ? 0 : run + 1;
+
+        if(run == count)
+        {
+            uint32_t first = slot + 1 - count;
+            for(uint32_t i = first; i <= slot; ++i)
+                device->slot_refs[i] = 1;
+
+            device->used += count;
+            device->cursor = slot + 1 < device->slots ? slot + 1 : 1;
+            return first;
+        }
+    }
+
+    return 0;
+}
+
+/* Devices are tried from the highest priority down; exclude masks out devices by index */
+uint32_t swap_alloc(uint32_t count, uint32_t exclude)
+{
+    uint32_t tried = exclude;
+
+    for(uint32_t pass = 0; pass < device_count; ++pass)
+    {
+        int32_t best = -1;
+
+        for(uint32_t i = 0; i < device_count; ++i)
+            if(!(tried & (0x1 << i)) && (best < 0 || devices[i]->priority > devices[best]->priority))
+                best = i;
+
+        if(best < 0)
+            break;
+
+        tried |= 0x1 << best;
+
+        if(devices[best]->slots - devices[best]->used < count)
+            continue;
+
+        uint32_t slot = device_alloc(devices[best], count);
+        if(slot)
+            return SWAP_ENTRY(best, slot);
+    }
+
+    return 0;
+}
+
+void swap_duplicate(uint32_t entry)
+{
+    swap_device_t *device = devices[SWAP_DEVICE(entry)];
+
+    if(device->slot_refs[SWAP_SLOT(entry)] == SWAP_MAX_REFS - 1)
+        PANIC("Swap slot reference overflow");
+
+    ++device->slot_refs[SWAP_SLOT(entry)];
+}
+
+void swap_free(uint32_t entry)
+{
+    swap_device_t *device = devices[SWAP_DEVICE(entry)];
+    uint32_t slot = SWAP_SLOT(entry);
+
+    if(device->slot_refs[slot] == 0)
+        PANIC("Swap slot freed twice");
+
+    if(--device->slot_refs[slot] == 0)
+    {
+        --device->used;
+        if(device->release)
+            device->release(device, slot);
+    }
+}
+
+int32_t swap_write(uint32_t entry, uint32_t count, void *pages)
+{
+    swap_device_t *device = devices[SWAP_DEVICE(entry)];
+    return device->write(device, SWAP_SLOT(entry), count, pages);
+}
+
+int32_t swap_read(uint32_t entry, uint32_t frame)
+{
+    swap_device_t *device = devices[SWAP_DEVICE(entry)];
+    uint32_t flags;
+
+    IRQ_SAVE(flags);
+    int32_t result = device->read(device, SWAP_SLOT(entry), kmap_slot(KMAP_DESTINATION, frame));
+    kunmap_slot(KMAP_DESTINATION);
+    IRQ_RESTORE(flags);
+
+    if(result == 0)
+        ++swap_stats.pages_in;
+
+    return result;
+}
+
+/* Mask of the devices to exclude from swap_alloc when allocating is not allowed */
+uint32_t swap_allocating_devices()
+{
+    uint32_t mask = 0;
+
+    for(uint32_t i = 0; i < device_count; ++i)
+        if(devices[i]->flags & SWAP_ALLOCATES)
+            mask |= 0x1 << i;
+
+    return mask;
+}
+
+uint32_t swap_free_slots()
+{
+    uint32_t slots = 0;
+
+    for(uint32_t i = 0; i < device_count; ++i)
+        slots += devices[i]->slots - devices[i]->used;
+
+    return slots;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <kernel/memory/vma.h>
+#include <kernel/memory/slab.h>
+
+static kmem_cache_t *vma_cache = 0;
+
+void vma_insert(page_directory_t *dir, vm_area_t *area)
+{
+    vm_area_t **link = &dir->areas;
+    while(*link && (*link)->start < area->start)
+        link = &(*link)->next;
+
+    area->next = *link;
+    *link = area;
+}
+
+vm_area_t *vma_add(page_directory_t *dir, uint32_t start, uint32_t end, uint32_t flags)
+{
+    if(!vma_cache)
+        vma_cache = kmem_cache_create("vm_area_t", sizeof(vm_area_t), 0, 0);
+
+    vm_area_t *area = (vm_area_t*) kmem_cache_alloc(vma_cache);
+    area->start = start & 0xFFFFF000;
+    area->end = (end + 0xFFF) & 0xFFFFF000;
+    area->flags = flags;
+    vma_insert(dir, area);
+    return area;
+}
+
+void vma_remove(page_directory_t *dir, vm_area_t *area)
+{
+    vm_area_t **link = &dir->areas;
+    while(*link && *link != area)
+        link = &(*link)->next;
+
+    if(*link)
+    {
+        *link = area->next;
+        kmem_cache_free(vma_cache, area);
+    }
+}
+
+vm_area_t *vma_find(page_directory_t *dir, uint32_t address)
+{
+    for(vm_area_t *area = dir->areas; area && area->start <= address; area = area->next)
+    {
+        if(address < area->end)
+            return area;
+    }
+
+    return 0;
+}
+
+/* Whether user code may access [start, start + size): syscalls check the
+   pointers they are handed with this before the kernel touches them */
+int32_t vma_user_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t flags)
+{
+    if(start + size < start)
+        return 0;
+
+    vm_area_t *area = vma_find(dir, start);
+    if(!area || start + size > area->end)
+        return 0;
+
+    flags |= VMA_USER;
+    return (area->flags & flags) == flags;
+}
+
+void vma_clone(page_directory_t *src, page_directory_t *dst)
+{
+    for(vm_area_t *area = src->areas; area; area = area->next)
+        vma_add(dst, area->start, area->end, area->flags);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include <kernel/memory/vmalloc.h>
+#include <kernel/memory/vma.h>
+#include <kernel/memory/vmm.h>
+
+extern page_directory_t *kernel_directory;
+
+static uint32_t find_gap(uint32_t size)
+{
+    uint32_t candidate = VMALLOC_START;
+
+    for(vm_area_t *area = kernel_directory->areas; area; area = area->next)
+    {
+        if(area->end + VMALLOC_GUARD <= candidate)
+            continue;
+
+        if(area->start >= candidate + size + VMALLOC_GUARD)
+            break;
+
+        candidate = area->end + VMALLOC_GUARD;
+    }
+
+    if(candidate + size > VMALLOC_END)
+        return 0;
+
+    return candidate;
+}
+
+void *vmalloc(uint32_t size)
+{
+    if(size == 0)
+        return 0;
+
+    size = (size + 0xFFF) & 0xFFFFF000;
+
+    uint32_t start = find_gap(size);
+    if(!start)
+        return 0;
+
+    vma_add(kernel_directory, start, start + size, VMA_WRITE);
+    vmm_map_range(kernel_directory, start, size, 0, VMM_WRITE | VMM_ALLOCATE);
+    return (void*) start;
+}
+
+void vfree(void *address)
+{
+    if(address == 0)
+        return;
+
+    vm_area_t *area = vma_find(kernel_directory, (uint32_t) address);
+    if(!area || area->start != (uint32_t) address || area->start < VMALLOC_START || area->end > VMALLOC_END)
+        PANIC("vfree of an unknown address");
+
+    vmm_unmap_range(kernel_directory, area->start, area->end - area->start, 1);
+    vma_remove(kernel_directory, area);
+}
\ No newline at end of file
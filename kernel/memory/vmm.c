@@ -0,0 +1,160 @@
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/frame.h>
+#include <kernel/memory/reclaim.h>
+
+static page_table_t *table_for(page_directory_t *dir, uint32_t page, int32_t make)
+{
+    uint32_t table_index = page / 1024;
+
+    if(dir->tablesPhysical[table_index] & PDE_LARGE)
+        return 0;
+
+    if(!dir->tables[table_index] && make)
+        get_page(page * 0x1000, 1, dir);
+
+    return dir->tables[table_index];
+}
+
+static uint32_t table_end(uint32_t page, uint32_t last)
+{
+    uint32_t end = (page & ~0x3FF) + 1024;
+    return end < last ? end : last;
+}
+
+void vmm_reserve_range(page_directory_t *dir, uint32_t start, uint32_t size)
+{
+    uint32_t page = start / 0x1000;
+    uint32_t last = page + (size + 0xFFF) / 0x1000;
+
+    while(page < last)
+    {
+        table_for(dir, page, 1);
+        page = table_end(page, last);
+    }
+}
+
+void vmm_map_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t physical, uint32_t flags)
+{
+    uint32_t page = start / 0x1000;
+    uint32_t last = page + (size + 0xFFF) / 0x1000;
+    uint32_t frame = physical / 0x1000;
+    uint32_t remapped = 0;
+
+    while(page < last)
+    {
+        page_table_t *table = table_for(dir, page, 1);
+        uint32_t end = table_end(page, last);
+
+        if(!table)
+        {
+            frame += end - page;
+            page = end;
+            continue;
+        }
+
+        for(; page < end; ++page)
+        {
+            page_t *entry = &table->pages[page % 1024];
+
+            if(flags & VMM_ALLOCATE)
+                alloc_frame_flags(entry, 0, (flags & VMM_WRITE) ? 1 : 0, (flags & VMM_ZERO) ? FRAME_ZERO : 0);
+            else if(entry->present && entry->frame == frame)
+            {
+                /* Same frame, but the permissions below may change */
+                remapped = 1;
+                ++frame;
+            }
+            else
+            {
+                if(entry->present || entry->swapped)
+                {
+                    /* Frames past the frame table (MMIO) are not refcounted */
+                    if(entry->swapped || entry->frame < number_of_frames)
+                        free_frame(entry);
+
+                    remapped = 1;
+                }
+
+                entry->present = 1;
+                entry->frame = frame;
+
+                if(frame < number_of_frames)
+                    frame_get(frame);
+
+                ++frame;
+            }
+
+            entry->rw = (flags & VMM_WRITE) ? 1 : 0;
+            entry->user = (flags & VMM_USER) ? 1 : 0;
+            entry->global = (flags & VMM_GLOBAL) ? 1 : 0;
+
+            /* Fresh anonymous user memory is swappable, like a demand-zero fault */
+            if((flags & VMM_ALLOCATE) && (flags & VMM_USER))
+                lru_add(entry->frame, entry);
+        }
+    }
+
+    if(remapped)
+        flush_tlb_range(dir, start, size);
+}
+
+void vmm_unmap_range(page_directory_t *dir, uint32_t start, uint32_t size, int32_t release)
+{
+    uint32_t page = start / 0x1000;
+    uint32_t last = page + (size + 0xFFF) / 0x1000;
+
+    while(page < last)
+    {
+        page_table_t *table = table_for(dir, page, 0);
+        uint32_t end = table_end(page, last);
+
+        for(; table && page < end; ++page)
+        {
+            page_t *entry = &table->pages[page % 1024];
+
+            if(!entry->present && !entry->swapped)
+                continue;
+
+            /* A swap slot is only reachable through its PTE, so it is dropped either way */
+            if(release || entry->swapped)
+                free_frame(entry);
+            else
+            {
+                entry->present = 0;
+                entry->frame = 0;
+            }
+        }
+
+        page = end;
+    }
+
+    flush_tlb_range(dir, start, size);
+}
+
+void vmm_protect_range(page_directory_t *dir, uint32_t start, uint32_t size, uint32_t flags)
+{
+    uint32_t page = start / 0x1000;
+    uint32_t last = page + (size + 0xFFF) / 0x1000;
+
+    while(page < last)
+    {
+        page_table_t *table = table_for(dir, page, 0);
+        uint32_t end = table_end(page, last);
+
+        for(; table && page < end; ++page)
+        {
+            page_t *entry = &table->pages[page % 1024];
+
+            if(!entry->present && !entry->swapped)
+                continue;
+
+            /* A COW frame is still shared: the write fault makes the copy */
+            entry->rw = (flags & VMM_WRITE) && !entry->cow ? 1 : 0;
+            entry->user = (flags & VMM_USER) ? 1 : 0;
+        }
+
+        page = end;
+    }
+
+    flush_tlb_range(dir, start, size);
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include <kernel/memory/zram.h>
+#include <kernel/memory/swap.h>
+#include <kernel/memory/frame.h>
+#include <kernel/memory/buddy.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
+
+#include <asm/system.h>
+#include <lz4.h>
+
+extern void fast_copy_page(void *destination, void *source);
+extern void fast_zero_page(void *destination);
+
+zram_stats_t zram_stats;
+
+static swap_device_t zram_device;
+static zram_slot_t *slots;
+static zram_class_t classes[ZRAM_CLASSES];
+static kmem_cache_t *zspage_cache;
+
+/* Only touched from reclaim and swap-in, both of which run with interrupts off */
+static uint16_t hash_table[LZ4_HASH_SIZE];
+static uint8_t object_buffer[0x1000];
+
+static void zspage_list_add(zspage_t **list, zspage_t *zspage)
+{
+    zspage->prev = 0;
+    zspage->next = *list;
+
+    if(*list)
+        (*list)->prev = zspage;
+
+    *list = zspage;
+}
+
+static void zspage_list_remove(zspage_t **list, zspage_t *zspage)
+{
+    if(zspage->prev)
+        zspage->prev->next = zspage->next;
+    else
+        *list = zspage->next;
+
+    if(zspage->next)
+        zspage->next->prev = zspage->prev;
+}
+
+/* Objects are ZRAM_CLASS_SIZE aligned, so they are moved a word at a time through the pool slot */
+static void zspage_copy(zspage_t *zspage, uint32_t offset, uint32_t *buffer, uint32_t length, int32_t write)
+{
+    while(length)
+    {
+        uint32_t within = offset & 0xFFF;
+        uint32_t chunk = 0x1000 - within < length ? 0x1000 - within : length;
+        uint32_t *mapped = (uint32_t*) ((uint8_t*) kmap_slot(KMAP_POOL, zspage->frames[offset / 0x1000]) + within);
+
+        for(uint32_t i = 0; i < chunk / 4; ++i)
+        {
+            if(write)
+                mapped[i] = buffer[i];
+            else
+                buffer[i] = mapped[i];
+        }
+
+        kunmap_slot(KMAP_POOL);
+        offset += chunk;
+        buffer += chunk / 4;
+        length -= chunk;
+    }
+}
+
+static zspage_t *zspage_create(uint32_t size_class)
+{
+    zram_class_t *class = &classes[size_class];
+
+    if(zram_stats.pool_frames + class->frames > zram_stats.pool_limit)
+        return 0;
+
+    zspage_t *zspage = (zspage_t*) kmem_cache_alloc(zspage_cache);
+
+    for(uint32_t i = 0; i < class->frames; ++i)
+    {
+        zspage->frames[i] = buddy_alloc(0);
+
+        if(zspage->frames[i] == BUDDY_NONE)
+        {
+            while(i--)
+                buddy_free(zspage->frames[i], 0);
+
+            kmem_cache_free(zspage_cache, zspage);
+            return 0;
+        }
+    }
+
+    for(uint32_t i = 0; i < ZRAM_MAX_OBJECTS / 32; ++i)
+        zspage->used[i] = 0;
+
+    zspage->size_class = size_class;
+    zspage->in_use = 0;
+    zram_stats.pool_frames += class->frames;
+
+    zspage_list_add(&class->partial, zspage);
+    return zspage;
+}
+
+static void zspage_destroy(zspage_t *zspage)
+{
+    zram_class_t *class = &classes[zspage->size_class];
+
+    zspage_list_remove(&class->partial, zspage);
+
+    for(uint32_t i = 0; i < class->frames; ++i)
+        buddy_free(zspage->frames[i], 0);
+
+    zram_stats.pool_frames -= class->frames;
+    kmem_cache_free(zspage_cache, zspage);
+}
+
+static int32_t pool_alloc(zram_slot_t *slot, uint32_t length)
+{
+    uint32_t size_class = (length - 1) / ZRAM_CLASS_SIZE;
+    zram_class_t *class = &classes[size_class];
+    zspage_t *zspage = class->partial ? class->partial : zspage_create(size_class);
+
+    if(!zspage)
+        return -1;
+
+    uint32_t object = 0;
+    while(zspage->used[object / 32] & (0x1 << (object % 32)))
+        ++object;
+
+    zspage->used[object / 32] |= 0x1 << (object % 32);
+
+    if(++zspage->in_use == class->objects)
+    {
+        zspage_list_remove(&class->partial, zspage);
+        zspage_list_add(&class->full, zspage);
+    }
+
+    slot->zspage = zspage;
+    slot->object = object;
+    return 0;
+}
+
+static void pool_free(zram_slot_t *slot)
+{
+    zspage_t *zspage = slot->zspage;
+    zram_class_t *class = &classes[zspage->size_class];
+
+    if(zspage->in_use-- == class->objects)
+    {
+        zspage_list_remove(&class->full, zspage);
+        zspage_list_add(&class->partial, zspage);
+    }
+
+    zspage->used[slot->object / 32] &= ~(0x1 << (slot->object % 32));
+
+    if(zspage->in_use == 0)
+        zspage_destroy(zspage);
+}
+
+static int32_t page_is_zero(uint32_t *page)
+{
+    for(uint32_t i = 0; i < 0x1000 / 4; ++i)
+        if(page[i])
+            return 0;
+
+    return 1;
+}
+
+static int32_t zram_store(zram_slot_t *slot, uint8_t *page)
+{
+    if(page_is_zero((uint32_t*) page))
+    {
+        slot->state = ZRAM_ZERO;
+        ++zram_stats.zero_pages;
+        return 0;
+    }
+
+    uint8_t *data = object_buffer;
+    int32_t length = lz4_compress(page, 0x1000, object_buffer, ZRAM_MAX_COMPRESSED, hash_table);
+
+    if(length < 0)
+    {
+        data = page;
+        length = 0x1000;
+    }
+
+    if(pool_alloc(slot, length) < 0)
+    {
+        ++zram_stats.failed_writes;
+        return -1;
+    }
+
+    zram_class_t *class = &classes[slot->zspage->size_class];
+    zspage_copy(slot->zspage, slot->object * class->size, (uint32_t*) data, class->size, 1);
+
+    slot->length = length;
+    slot->state = ZRAM_STORED;
+
+    ++zram_stats.stored_pages;
+    zram_stats.compressed_bytes += length;
+    if(length == 0x1000)
+        ++zram_stats.incompressible_pages;
+
+    return 0;
+}
+
+static int32_t zram_write(swap_device_t *device, uint32_t slot, uint32_t count, void *pages)
+{
+    /* Pages stored before a failure are dropped by the caller's swap_free through zram_release */
+    for(uint32_t i = 0; i < count; ++i)
+        if(zram_store(&slots[slot + i], (uint8_t*) pages + i * 0x1000) < 0)
+            return -1;
+
+    return 0;
+}
+
+static int32_t zram_read(swap_device_t *device, uint32_t slot, void *page)
+{
+    zram_slot_t *entry = &slots[slot];
+    int32_t result = 0;
+    uint64_t start, end;
+
+    RDTSC(start);
+
+    if(entry->state == ZRAM_ZERO)
+        fast_zero_page(page);
+    else if(entry->state == ZRAM_STORED)
+    {
+        zram_class_t *class = &classes[entry->zspage->size_class];
+
+        if(entry->length == 0x1000)
+            zspage_copy(entry->zspage, entry->object * class->size, (uint32_t*) page, 0x1000, 0);
+        else
+        {
+            zspage_copy(entry->zspage, entry->object * class->size, (uint32_t*) object_buffer, class->size, 0);
+            if(lz4_decompress(object_buffer, entry->length, (uint8_t*) page, 0x1000) != 0x1000)
+                result = -1;
+        }
+    }
+    else
+        result = -1;
+
+    RDTSC(end);
+    ++zram_stats.faults;
+    zram_stats.fault_cycles += end - start;
+    return result;
+}
+
+static void zram_release(swap_device_t *device, uint32_t slot)
+{
+    zram_slot_t *entry = &slots[slot];
+
+    if(entry->state == ZRAM_ZERO)
+        --zram_stats.zero_pages;
+    else if(entry->state == ZRAM_STORED)
+    {
+        --zram_stats.stored_pages;
+        zram_stats.compressed_bytes -= entry->length;
+        if(entry->length == 0x1000)
+            --zram_stats.incompressible_pages;
+
+        pool_free(entry);
+    }
+
+    entry->state = ZRAM_EMPTY;
+    entry->zspage = 0;
+}
+
+/* Picks the zspage length, up to ZRAM_MAX_ZSPAGE_FRAMES, that wastes the smallest share of its tail */
+static void init_class(zram_class_t *class, uint32_t size)
+{
+    uint32_t best = 1;
+
+    for(uint32_t frames = 2; frames <= ZRAM_MAX_ZSPAGE_FRAMES; ++frames)
+        if((frames * 0x1000 % size) * best < (best * 0x1000 % size) * frames)
+            best = frames;
+
+    class->size = size;
+    class->frames = best;
+    class->objects = best * 0x1000 / size;
+    class->partial = 0;
+    class->full = 0;
+}
+
+void init_zram()
+{
+    uint32_t count = number_of_frames < SWAP_MAX_SLOTS ? number_of_frames : SWAP_MAX_SLOTS;
+
+    for(uint32_t i = 0; i < ZRAM_CLASSES; ++i)
+        init_class(&classes[i], (i + 1) * ZRAM_CLASS_SIZE);
+
+    zspage_cache = kmem_cache_create("zspage", sizeof(zspage_t), 0, 0);
+
+    slots = (zram_slot_t*) kmalloc(sizeof(zram_slot_t) * count);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        slots[i].zspage = 0;
+        slots[i].state = ZRAM_EMPTY;
+    }
+
+    zram_stats.pool_limit = number_of_frames / ZRAM_POOL_DIVISOR;
+
+    zram_device.name = "zram";
+    zram_device.slots = count;
+    zram_device.priority = ZRAM_PRIORITY;
+    zram_device.flags = SWAP_ALLOCATES;
+    zram_device.read = zram_read;
+    zram_device.write = zram_write;
+    zram_device.release = zram_release;
+    zram_device.data = 0;
+
+    swap_on(&zram_device);
+}
+
+/* Uncompressed bytes held per hundred bytes of pool, so 200 means the pool doubles what it holds */
+uint32_t zram_ratio()
+{
+    if(zram_stats.pool_frames == 0)
+        return 0;
+
+    return (uint32_t) ((uint64_t) zram_stats.stored_pages * 100 / zram_stats.pool_frames);
+}
\ No newline at end of file
@@ -1,6 +1,33 @@
 #include <kernel/syscall.h>
+#include <kernel/cpu/isr.h>
+#include <system/sysinfo.h>
+
+typedef uint32_t (*syscall_t)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+static void syscall_handler(registers_t *regs);
+
+// Indexed by the number passed in eax
+static void *syscalls[] =
+{
+    &get_sysinfo,
+};
+
+static uint32_t num_syscalls = sizeof(syscalls) / sizeof(syscalls[0]);
+
+DEFN_SYSCALL2(get_sysinfo, SYSCALL_GET_SYSINFO, sysinfo_t*, uint32_t)
 
 void initialise_syscalls()
 {
-    
+    register_interrupt_handler(0x80, &syscall_handler);
+}
+
+static void syscall_handler(registers_t *regs)
+{
+    if (regs->eax >= num_syscalls)
+        return;
+
+    // Arguments arrive in ebx, ecx, edx, esi and edi. Passing all five is
+    // harmless under cdecl, where the callee ignores the ones it lacks.
+    syscall_t call = (syscall_t) syscalls[regs->eax];
+    regs->eax = call(regs->ebx, regs->ecx, regs->edx, regs->esi, regs->edi);
 }
\ No newline at end of file
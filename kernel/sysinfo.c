@@ -0,0 +1,30 @@
+#include <system/sysinfo.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/buddy.h>
+#include <kernel/memory/vma.h>
+
+extern page_directory_t *current_directory;
+
+// Reachable from ring 3 through int 0x80, so `info` must be writable user
+// memory. Returns 0, or -1 if the pointer is rejected.
+int32_t get_sysinfo(sysinfo_t *info, uint32_t what)
+{
+    if(!vma_user_range(current_directory, (uint32_t) info, sizeof(sysinfo_t), VMA_WRITE))
+        return -1;
+
+    if(what & SYSINFO_MEMORY)
+    {
+        heap_stats_t stats;
+        kheap_stats(&stats);
+
+        info->kernel_heap_usage = stats.bytes_in_use;
+        info->kernel_heap_size = stats.heap_size;
+        info->kernel_heap_holes = stats.hole_count;
+        info->kernel_heap_largest_hole = stats.largest_hole;
+
+        info->ram_total = number_of_frames * 0x1000;
+        info->ram_usage = (number_of_frames - buddy_free_frames()) * 0x1000;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -1,123 +1,270 @@
 #include <kernel/task.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/vma.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/cpu/timer.h>
+#include <kernel/cpu/fpu.h>
+#include <kernel/cpu/tss.h>
 
 volatile task_t *current_task;
-volatile task_t *ready_queue;
+
+/* One FIFO per priority level plus a bitmap of the non-empty ones, so
+   picking the next task and queueing one are both constant time. The
+   running task is never on a queue. */
+typedef struct RunQueue
+{
+    task_t *head[SCHED_PRIORITIES];
+    task_t *tail[SCHED_PRIORITIES];
+    uint32_t bitmap;
+} run_queue_t;
+
+/* A task that uses up its slice moves to the expired queue and only runs
+   again once everything left in the active one has blocked or expired
+   too, at which point the two are swapped. Priority orders tasks within
+   a round, but every runnable task gets a slice per round. */
+static run_queue_t run_queues[2];
+static run_queue_t *active = &run_queues[0];
+static run_queue_t *expired = &run_queues[1];
+
+// Runs when both queues are empty, and is never queued itself
+static task_t *idle_task = 0;
+
+// Exited kernel threads, freed once they are off the CPU for good
+static task_t *dead_tasks = 0;
 
 extern page_directory_t *kernel_directory;
 extern page_directory_t *current_directory;
 
 extern void alloc_frame(page_t *, int32_t, int32_t);
 extern uint32_t initial_esp;
-extern uint32_t read_epi();
 
 uint32_t next_pid = 1;
 
+volatile uint32_t need_resched = 0;
+static uint32_t timeslice_ticks = 1;
+
+static kmem_cache_t *task_cache;
+
+static void task_init_accounting(task_t *task)
+{
+    task->timeslice = timeslice_ticks;
+    task->user_ticks = 0;
+    task->kernel_ticks = 0;
+    task->switches = 0;
+    task->cycles = 0;
+    task->switched_in = 0;
+}
+
+static void run_queue_add(run_queue_t *queue, task_t *task)
+{
+    if (task == idle_task)
+        return;
+
+    uint32_t priority = task->static_priority > task->boost ? task->static_priority - task->boost : 0;
+
+    task->priority = priority;
+    task->next = 0;
+
+    if (queue->tail[priority])
+        queue->tail[priority]->next = task;
+    else
+        queue->head[priority] = task;
+
+    queue->tail[priority] = task;
+    queue->bitmap |= 0x1 << priority;
+}
+
+// The CPU pushes interrupt frames onto esp0 itself, and a page fault
+// there cannot be handled, so kernel stacks are faulted in up front
+// instead of on first use like the rest of the heap.
+static uint32_t kernel_stack_alloc()
+{
+    uint32_t stack = kmalloc_a(STACK_SIZE);
+
+    for (uint32_t offset = 0; offset < STACK_SIZE; offset += 0x1000)
+        *(volatile uint8_t*) (stack + offset) = 0;
+
+    return stack;
+}
+
+static void sched_enqueue(task_t *task)
+{
+    run_queue_add(active, task);
+}
+
+static task_t *sched_dequeue()
+{
+    if (!active->bitmap)
+    {
+        run_queue_t *queue = active;
+        active = expired;
+        expired = queue;
+    }
+
+    if (!active->bitmap)
+        return idle_task;
+
+    uint32_t priority = __builtin_ctz(active->bitmap);
+    task_t *task = active->head[priority];
+
+    active->head[priority] = task->next;
+    if (!task->next)
+    {
+        active->tail[priority] = 0;
+        active->bitmap &= ~(0x1 << priority);
+    }
+
+    task->next = 0;
+    return task;
+}
+
+void task_set_nice(task_t *task, int32_t nice)
+{
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    if (nice > NICE_MAX)
+        nice = NICE_MAX;
+
+    // Applies from the next time the task is queued
+    task->nice = nice;
+    task->static_priority = SCHED_DEFAULT_PRIORITY + nice;
+}
+
+void sched_set_timeslice(uint32_t milliseconds)
+{
+    uint32_t ticks = milliseconds * timer_frequency / 1000;
+    timeslice_ticks = ticks ? ticks : 1;
+}
+
 void init_taskmanager()
 {
     CLI();
 
     move_stack((void *) 0xE0000000, 0x2000);
 
-    current_task = ready_queue = (task_t *) kmalloc(sizeof(task_t));
+    task_cache = kmem_cache_create("task_t", sizeof(task_t), 0, 0);
+    sched_set_timeslice(SCHED_TIMESLICE_MS);
+
+    current_task = (task_t *) kmem_cache_alloc(task_cache);
     current_task->id = ++next_pid;
     current_task->esp = 0;
-    current_task->ebp = 0;
-    current_task->eip = 0;
     current_task->page_directory = current_directory;
+    current_task->cr3 = current_directory->physicalAddr;
     current_task->next = 0;
-    current_task->kernel_stack = kmalloc_a(STACK_SIZE);
+    current_task->kernel_stack = kernel_stack_alloc();
+    current_task->fpu_state = 0;
+    current_task->state = TASK_RUNNABLE;
+    current_task->boost = 0;
+    task_set_nice((task_t*) current_task, 0);
+    current_task->priority = current_task->static_priority;
+    task_init_accounting((task_t*) current_task);
+    RDTSC(current_task->switched_in);
+
+    // Nothing has switched to the boot task, so point esp0 at its stack
+    // here or its first interrupt from ring 3 has nowhere to go
+    setup();
 
     STI();
 }
 
-void task_switch()
+// Lays out a switch_to frame that returns into entry. entry starts with
+// interrupts off and must never return.
+void task_init_context(task_t *task, uint32_t stack_top, void (*entry)())
 {
-    if (!current_task)
-        return;
+    uint32_t *stack = (uint32_t*) stack_top;
 
-    uint32_t esp, ebp, eip;
-    asm volatile("mov %%esp, %0" : "=r"(esp));
-    asm volatile("mov %%ebp, %0" : "=r"(ebp));
+    *--stack = (uint32_t) entry;
+    *--stack = 0;   // ebp
+    *--stack = 0;   // ebx
+    *--stack = 0;   // esi
+    *--stack = 0;   // edi
 
-    eip = read_eip();
+    task->esp = (uint32_t) stack;
+}
 
-    if (eip == 0x12345)
+void task_switch()
+{
+    if (!current_task)
         return;
 
-    current_task->eip = eip;
-    current_task->esp = esp;
-    current_task->ebp = ebp;
-    
-    current_task = current_task->next;
-    if (!current_task) current_task = ready_queue;
+    uint32_t flags;
+    IRQ_SAVE(flags);
 
-    eip = current_task->eip;
-    esp = current_task->esp;
-    ebp = current_task->ebp;
+    task_t *prev = (task_t*) current_task;
+    if (prev->state == TASK_RUNNABLE)
+        run_queue_add(prev->timeslice ? active : expired, prev);
 
-    current_directory = current_task->page_directory;
+    // The idle task never blocks, so there is always something to run
+    task_t *next = sched_dequeue();
+    next->timeslice = timeslice_ticks;
+    need_resched = 0;
 
-    setup();
+    if (next != prev)
+    {
+        uint64_t now;
+        RDTSC(now);
+        prev->cycles += now - prev->switched_in;
+        next->switched_in = now;
+        ++next->switches;
+
+        current_task = next;
+        current_directory = next->page_directory;
+        setup();
+        fpu_switch(prev, next);
+
+        switch_to(prev, next);
+    }
 
-    asm volatile("\
-        cli;\
-        mov %0, %%ecx;\
-        mov %1, %%esp;\
-        mov %2, %%ebp;\
-        mov %3, %%cr3;\
-        mov $0x12345, %%eax;\
-        sti;\
-        jmp *%%ecx" : : "r"(eip), "r"(esp), "r"(ebp), "r"(current_directory->physicalAddr)
-    );
+    // Back on prev's stack: these are the flags it went to sleep with
+    IRQ_RESTORE(flags);
+}
+
+static void fork_clone(task_t *child)
+{
+    child->page_directory = clone_directory(current_directory);
+    child->cr3 = child->page_directory->physicalAddr;
 }
 
 int32_t task_fork()
 {
-    asm volatile("cli");
+    uint32_t flags;
+    IRQ_SAVE(flags);
 
     task_t *parent_task = (task_t*) current_task;
 
-    page_directory_t *directory = clone_directory(current_directory);
-
-    task_t *new_task = (task_t*) kmalloc(sizeof(task_t));
+    task_t *new_task = (task_t*) kmem_cache_alloc(task_cache);
     new_task->id = next_pid++;
-    new_task->esp = new_task->ebp = 0;
-    new_task->eip = 0;
-    new_task->page_directory = directory;
-    current_task->kernel_stack = kmalloc_a(STACK_SIZE);
+    new_task->kernel_stack = kernel_stack_alloc();
     new_task->next = 0;
+    new_task->state = TASK_RUNNABLE;
+    new_task->boost = 0;
+    task_set_nice(new_task, parent_task->nice);
+    task_init_accounting(new_task);
+    fpu_fork(parent_task, new_task);
 
-    task_t *tmp_task = (task_t*)ready_queue;
-    while (tmp_task->next)
-        tmp_task = tmp_task->next;
-
-    tmp_task->next = new_task;
-
-    uint32_t eip = read_eip();
+    fork_snapshot(new_task, &fork_clone);
 
     if (current_task != parent_task)
+    {
+        IRQ_RESTORE(flags);
         return 0;
+    }
 
-    uint32_t esp; asm volatile("mov %%esp, %0" : "=r"(esp));
-    uint32_t ebp; asm volatile("mov %%ebp, %0" : "=r"(ebp));
-    new_task->esp = esp;
-    new_task->ebp = ebp;
-    new_task->eip = eip;
-
-    STI();
+    sched_enqueue(new_task);
+    IRQ_RESTORE(flags);
 
     return new_task->id;
 }
 
+// The boot task keeps this stack when it drops to ring 3, so it is mapped
+// as user memory and its pages go on the swap LRU. That is only safe
+// because the task never sleeps in the kernel on it before the switch;
+// afterwards the kernel runs on kernel_stack through the TSS.
 void move_stack(void *new_stack_start, uint32_t size)
 {
-    for(uint32_t i = (uint32_t) new_stack_start; i >= ((uint32_t) new_stack_start - size); i -= 0x1000)
-        alloc_frame(get_page(i, 1, current_directory), 0, 1);
-
-    uint32_t page_directory_address;
-
-    asm volatile("mov %%cr3, %0" : "=r" (page_directory_address));
-    asm volatile("mov %0, %%cr3" : : "r" (page_directory_address));
+    vma_add(current_directory, (uint32_t) new_stack_start - size, (uint32_t) new_stack_start + 0x1000, VMA_WRITE | VMA_USER);
+    vmm_map_range(current_directory, (uint32_t) new_stack_start - size, size + 0x1000, 0, VMM_WRITE | VMM_USER | VMM_ALLOCATE);
 
     uint32_t old_stack_pointer; 
     asm volatile("mov %%esp, %0" : "=r" (old_stack_pointer));
@@ -152,7 +299,265 @@ void setup()
     set_kernel_stack(current_task->kernel_stack + STACK_SIZE);
 }
 
+// Called from the timer interrupt with interrupts off.
+void sched_tick(registers_t *regs)
+{
+    task_t *task = (task_t*) current_task;
+    if (!task)
+        return;
+
+    if (regs->cs & 0x3)
+        ++task->user_ticks;
+    else
+        ++task->kernel_ticks;
+
+    if (task->timeslice)
+    {
+        if (--task->timeslice)
+            return;
+
+        // Using up a whole slice is what batch work does, so it costs boost
+        if (task->boost)
+            --task->boost;
+    }
+
+    // Keeps asking until it gets off the CPU: a task queued after the
+    // slice ran out has to get its turn even if it ranks lower
+    if (active->bitmap || expired->bitmap)
+        need_resched = 1;
+}
+
+void wait_queue_init(wait_queue_t *queue, uint8_t boost)
+{
+    queue->head = 0;
+    queue->tail = 0;
+    queue->boost = boost < SCHED_MAX_BOOST ? boost : SCHED_MAX_BOOST;
+}
+
+// The caller disables interrupts around its wait condition and the
+// sleep, otherwise a wake-up arriving in between is lost.
+void task_sleep_on(wait_queue_t *queue)
+{
+    task_t *task = (task_t*) current_task;
+
+    task->state = TASK_BLOCKED;
+    task->next = 0;
+
+    if (queue->tail)
+        queue->tail->next = task;
+    else
+        queue->head = task;
+    queue->tail = task;
+
+    task_switch();
+}
+
+void task_wake_up(wait_queue_t *queue)
+{
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    task_t *task = queue->head;
+    queue->head = queue->tail = 0;
+
+    while (task)
+    {
+        task_t *next = task->next;
+
+        if (task->boost < queue->boost)
+            task->boost = queue->boost;
+
+        task->state = TASK_RUNNABLE;
+        sched_enqueue(task);
+
+        if (task->priority < current_task->priority)
+            need_resched = 1;
+
+        task = next;
+    }
+
+    IRQ_RESTORE(flags);
+}
+
+// Runs at the end of every interrupt and syscall. Only user code is
+// preempted: nothing in the kernel guards the heap or the frame lists
+// against a second task, so kernel paths keep the CPU until they return
+// to user mode or call task_yield() themselves.
+void task_preempt(registers_t *regs)
+{
+    if (need_resched && (regs->cs & 0x3))
+        task_switch();
+}
+
+void task_yield()
+{
+    task_switch();
+}
+
+static void kthread_entry()
+{
+    task_t *self = (task_t*) current_task;
+
+    STI();
+    self->entry(self->arg);
+    kthread_exit();
+}
+
+// Kernel threads run on kernel_directory with their own stack from the
+// heap: nothing is cloned, and switching between two of them never
+// touches CR3. Like all kernel code they are not preempted, so long
+// loops should call task_yield() when need_resched is set.
+static task_t *kthread_alloc(void (*fn)(void *arg), void *arg)
+{
+    task_t *task = (task_t*) kmem_cache_alloc(task_cache);
+    task->id = next_pid++;
+    task->page_directory = kernel_directory;
+    task->cr3 = kernel_directory->physicalAddr;
+    task->kernel_stack = kernel_stack_alloc();
+    task->next = 0;
+    task->state = TASK_RUNNABLE;
+    task->boost = 0;
+    task->fpu_state = 0;
+    task->entry = fn;
+    task->arg = arg;
+    task_set_nice(task, 0);
+    task_init_accounting(task);
+    task_init_context(task, task->kernel_stack + STACK_SIZE, &kthread_entry);
+
+    return task;
+}
+
+task_t *kthread_create(void (*fn)(void *arg), void *arg)
+{
+    task_t *task = kthread_alloc(fn, arg);
+
+    uint32_t flags;
+    IRQ_SAVE(flags);
+    sched_enqueue(task);
+    IRQ_RESTORE(flags);
+
+    return task;
+}
+
+void kthread_exit()
+{
+    CLI();
+
+    task_t *task = (task_t*) current_task;
+    task->state = TASK_DEAD;
+    task->next = dead_tasks;
+    dead_tasks = task;
+
+    task_switch();
+    PANIC("Dead kernel thread was scheduled");
+}
+
+static void reap_dead_tasks()
+{
+    uint32_t flags;
+    IRQ_SAVE(flags);
+    task_t *task = dead_tasks;
+    dead_tasks = 0;
+    IRQ_RESTORE(flags);
+
+    while (task)
+    {
+        task_t *next = task->next;
+
+        fpu_release(task);
+        kfree((void*) task->kernel_stack);
+        kmem_cache_free(task_cache, task);
+
+        task = next;
+    }
+}
+
+static void idle_thread(void *arg)
+{
+    for(;;)
+    {
+        reap_dead_tasks();
+        HLT();
+
+        if (need_resched)
+            task_yield();
+    }
+}
+
+// The idle thread is never queued: sched_dequeue() falls back to it once
+// both queues are empty, including before it has run for the first time.
+void task_idle_start()
+{
+    task_t *task = kthread_alloc(&idle_thread, 0);
+    task->static_priority = SCHED_IDLE_PRIORITY;
+    task->priority = SCHED_IDLE_PRIORITY;
+
+    uint32_t flags;
+    IRQ_SAVE(flags);
+    idle_task = task;
+    IRQ_RESTORE(flags);
+}
+
 int32_t task_get_pid()
 {
     return current_task->id;
+}
+
+static task_t bench_self;
+static task_t bench_peer;
+
+static void bench_peer_loop()
+{
+    for(;;)
+        switch_to(&bench_peer, &bench_self);
+}
+
+static uint32_t bench_round_trips(uint32_t iterations)
+{
+    uint64_t start, end;
+
+    RDTSC(start);
+    for (uint32_t i = 0; i < iterations; ++i)
+        switch_to(&bench_self, &bench_peer);
+    RDTSC(end);
+
+    return (uint32_t) ((end - start) / (iterations * 2));
+}
+
+// Measures switch_to on its own, in cycles per switch. `shared` is the
+// common case of two tasks on one directory, where the CR3 load is
+// skipped. `reload` writes CR3 on every switch, which is what the
+// read_eip based switch used to do unconditionally. It gives the peer
+// the same directory with an ignored low bit set, so the values differ
+// and the TLB is flushed without needing a second address space. The
+// kernel's global entries would survive that flush, so CR4.PGE is off
+// for the run and every switch pays for a full TLB refill.
+void task_switch_benchmark(uint32_t iterations, uint32_t *shared, uint32_t *reload)
+{
+    if (!iterations)
+        iterations = 1;
+
+    uint32_t flags;
+    IRQ_SAVE(flags);
+
+    uint32_t stack = kernel_stack_alloc();
+    task_init_context(&bench_peer, stack + STACK_SIZE, &bench_peer_loop);
+
+    bench_self.cr3 = current_directory->physicalAddr;
+    bench_peer.cr3 = bench_self.cr3;
+    *shared = bench_round_trips(iterations);
+
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" :: "r"(cr4 & ~CR4_PGE));
+
+    bench_peer.cr3 = bench_self.cr3 | 0x1;
+    *reload = bench_round_trips(iterations);
+
+    // Setting PGE again flushes the TLB once more, globals included
+    asm volatile("mov %0, %%cr4" :: "r"(cr4));
+
+    // The peer is parked inside switch_to and never resumed again
+    kfree((void*) stack);
+    IRQ_RESTORE(flags);
 }
\ No newline at end of file
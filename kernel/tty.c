@@ -1,8 +1,13 @@
 #include <kernel/tty.h>
 #include <system/sysinfo.h>
 #include <fs/filesystem.h>
+#include <kernel/task.h>
+#include <drivers/keyboard.h>
+#include <drivers/display.h>
 #include <string.h>
 
+static char key_buffer[256];
+
 void init_tty(filesystem_node_t *node)
 {
     char dir[MAX_FILENAME] = node->name;
@@ -15,4 +20,51 @@ void execute_command(char *command)
     {
         printf("Current Kernel Version: %s", KERNEL_VERSION);
     }
+    else if(strcmp(command, "switchbench") == 0)
+    {
+        uint32_t shared, reload;
+        task_switch_benchmark(10000, &shared, &reload);
+        printf("Context switch: %d cycles, %d cycles with a full TLB flush", shared, reload);
+    }
+}
+
+// Runs the command line on its own thread. Commands used to execute
+// inside the keyboard interrupt; here the thread sleeps in
+// keyboard_read() instead, which also earns it the input boost.
+static void terminal_thread(void *arg)
+{
+    for(;;)
+    {
+        uint8_t scancode = keyboard_read();
+
+        if (scancode > SC_MAX) 
+            continue;
+
+        if (scancode == BACKSPACE) 
+        {
+            if (strback(key_buffer))
+                print_backspace();    
+        } 
+        else if (scancode == ENTER) 
+        {
+            print_nl();
+            execute_command(key_buffer);
+            key_buffer[0] = '\0';
+        } 
+        else 
+        {
+            char letter = sc_ascii[(int32_t) scancode];
+            strappchr(key_buffer, letter);
+            char str[2] = {
+                letter, 
+                '\0'
+            };
+            print(str);
+        }
+    }
+}
+
+void init_terminal()
+{
+    kthread_create(&terminal_thread, 0);
 }
@@ -12,11 +12,7 @@ list_t *list_init(int64_t item_size)
 void list_append(list_t *list, void *item)
 {
     list->size++;
-
-    if(list->items)
-        list->items = realloc(list->items, (list->size * list->item_size));
-        
-    list->items = malloc(list->item_size);
+    list->items = realloc(list->items, list->size * sizeof(void*));
     list->items[list->size - 1] = item;
 }
 
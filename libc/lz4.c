@@ -0,0 +1,180 @@
+#include <lz4.h>
+
+static uint32_t read32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint32_t hash(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t *write_length(uint8_t *op, uint32_t length)
+{
+    while(length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+
+    *op++ = length;
+    return op;
+}
+
+static uint8_t *write_sequence(uint8_t *op, uint8_t *end, const uint8_t *literals, uint32_t literal_length, uint32_t offset, uint32_t match_length)
+{
+    /* Token, literal run, offset and both length extensions at their worst */
+    if(op + 1 + literal_length + literal_length / 255 + 1 + 2 + match_length / 255 + 1 > end)
+        return 0;
+
+    uint8_t *token = op++;
+    *token = (literal_length >= 15 ? 15 : literal_length) << 4;
+    if(literal_length >= 15)
+        op = write_length(op, literal_length - 15);
+
+    for(uint32_t i = 0; i < literal_length; ++i)
+        *op++ = literals[i];
+
+    if(offset == 0)
+        return op;
+
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+
+    match_length -= LZ4_MIN_MATCH;
+    *token |= match_length >= 15 ? 15 : match_length;
+    if(match_length >= 15)
+        op = write_length(op, match_length - 15);
+
+    return op;
+}
+
+int32_t lz4_compress(const uint8_t *source, uint32_t length, uint8_t *destination, uint32_t capacity, uint16_t *table)
+{
+    const uint8_t *ip = source;
+    const uint8_t *anchor = source;
+    const uint8_t *end = source + length;
+    uint8_t *op = destination;
+    uint8_t *op_end = destination + capacity;
+
+    if(length > LZ4_MAX_OFFSET + 1)
+        return -1;
+
+    for(uint32_t i = 0; i < LZ4_HASH_SIZE; ++i)
+        table[i] = 0;
+
+    if(length > LZ4_MF_LIMIT)
+    {
+        const uint8_t *limit = end - LZ4_MF_LIMIT;
+        const uint8_t *match_limit = end - LZ4_LAST_LITERALS;
+
+        while(ip < limit)
+        {
+            uint32_t sequence = read32(ip);
+            uint32_t slot = hash(sequence);
+            const uint8_t *ref = source + table[slot];
+            table[slot] = ip - source;
+
+            if(ref >= ip || read32(ref) != sequence)
+            {
+                ++ip;
+                continue;
+            }
+
+            while(ip > anchor && ref > source && ip[-1] == ref[-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            const uint8_t *match_end = ip + LZ4_MIN_MATCH;
+            const uint8_t *ref_end = ref + LZ4_MIN_MATCH;
+            while(match_end < match_limit && *match_end == *ref_end)
+            {
+                ++match_end;
+                ++ref_end;
+            }
+
+            op = write_sequence(op, op_end, anchor, ip - anchor, ip - ref, match_end - ip);
+            if(!op)
+                return -1;
+
+            ip = match_end;
+            anchor = ip;
+        }
+    }
+
+    op = write_sequence(op, op_end, anchor, end - anchor, 0, 0);
+    if(!op)
+        return -1;
+
+    return op - destination;
+}
+
+int32_t lz4_decompress(const uint8_t *source, uint32_t length, uint8_t *destination, uint32_t capacity)
+{
+    const uint8_t *ip = source;
+    const uint8_t *end = source + length;
+    uint8_t *op = destination;
+    uint8_t *op_end = destination + capacity;
+
+    while(ip < end)
+    {
+        uint8_t token = *ip++;
+        uint32_t literal_length = token >> 4;
+        uint8_t byte;
+
+        if(literal_length == 15)
+        {
+            do
+            {
+                if(ip >= end)
+                    return -1;
+                byte = *ip++;
+                literal_length += byte;
+            } while(byte == 255);
+        }
+
+        if(literal_length > (uint32_t) (end - ip) || literal_length > (uint32_t) (op_end - op))
+            return -1;
+
+        for(uint32_t i = 0; i < literal_length; ++i)
+            *op++ = *ip++;
+
+        /* The final sequence carries literals only */
+        if(ip == end)
+            break;
+
+        if(end - ip < 2)
+            return -1;
+
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if(offset == 0 || offset > (uint32_t) (op - destination))
+            return -1;
+
+        uint32_t match_length = token & 0xF;
+        if(match_length == 15)
+        {
+            do
+            {
+                if(ip >= end)
+                    return -1;
+                byte = *ip++;
+                match_length += byte;
+            } while(byte == 255);
+        }
+
+        match_length += LZ4_MIN_MATCH;
+        if(match_length > (uint32_t) (op_end - op))
+            return -1;
+
+        const uint8_t *ref = op - offset;
+        while(match_length--)
+            *op++ = *ref++;
+    }
+
+    return op - destination;
+}
\ No newline at end of file
@@ -10,9 +10,14 @@ void memset(void *dst, uint8_t value, size_t nbytes)
 {
 }
 
-void malloc(uint32_t size)
+void *malloc(uint32_t size)
 {
-    kmalloc(size);
+    return (void*) kmalloc(size);
+}
+
+void *realloc(void *item, uint32_t size)
+{
+    return krealloc(item, size);
 }
 
 void free(void *item)